@@ -0,0 +1,208 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gf/Image.h>
+
+// Usage: krokodile-atlas <atlas.png> <atlas_regions.h> <Name>=<image.png>...
+//
+// Packs the images in a single texture with a shelf algorithm, and writes
+// a header with the normalized texture rectangle of every image.
+
+namespace {
+  constexpr unsigned AtlasWidth = 2048;
+  constexpr unsigned Padding = 2; // extruded border, avoids bleeding with smooth textures
+
+  struct Entry {
+    std::string name;
+    std::string path;
+    gf::Image image;
+    gf::Vector2u size;
+    gf::Vector2u position;
+  };
+
+  unsigned nextPowerOfTwo(unsigned value) {
+    unsigned result = 1;
+
+    while (result < value) {
+      result *= 2;
+    }
+
+    return result;
+  }
+
+  void blit(std::vector<uint8_t>& pixels, unsigned atlasWidth, const Entry& entry) {
+    const uint8_t *source = entry.image.getPixelsPtr();
+    const unsigned width = entry.size.x;
+    const unsigned height = entry.size.y;
+
+    // copy the image, then extrude its border in the padding
+    for (unsigned y = 0; y < height + 2 * Padding; ++y) {
+      unsigned sourceY = std::min(y > Padding ? y - Padding : 0, height - 1);
+
+      for (unsigned x = 0; x < width + 2 * Padding; ++x) {
+        unsigned sourceX = std::min(x > Padding ? x - Padding : 0, width - 1);
+
+        std::size_t from = (static_cast<std::size_t>(sourceY) * width + sourceX) * 4;
+        std::size_t to = (static_cast<std::size_t>(entry.position.y - Padding + y) * atlasWidth + (entry.position.x - Padding + x)) * 4;
+        std::memcpy(&pixels[to], &source[from], 4);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0] << " <atlas.png> <atlas_regions.h> <Name>=<image.png>...\n";
+    return 1;
+  }
+
+  std::string imageOutput = argv[1];
+  std::string headerOutput = argv[2];
+
+  std::vector<Entry> entries;
+
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto equal = arg.find('=');
+
+    if (equal == std::string::npos) {
+      std::cerr << "Invalid argument: '" << arg << "', expected <Name>=<image.png>\n";
+      return 1;
+    }
+
+    Entry entry;
+    entry.name = arg.substr(0, equal);
+    entry.path = arg.substr(equal + 1);
+
+    if (!entry.image.loadFromFile(entry.path)) {
+      std::cerr << "Could not load image: '" << entry.path << "'\n";
+      return 1;
+    }
+
+    entry.size = entry.image.getSize();
+
+    if (entry.size.x + 2 * Padding > AtlasWidth) {
+      std::cerr << "Image too large for the atlas: '" << entry.path << "'\n";
+      return 1;
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  // shelf packing, tallest images first
+  std::vector<std::size_t> order(entries.size());
+
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&entries](std::size_t lhs, std::size_t rhs) {
+    return entries[lhs].size.y > entries[rhs].size.y;
+  });
+
+  unsigned shelfX = 0;
+  unsigned shelfY = 0;
+  unsigned shelfHeight = 0;
+
+  for (auto index : order) {
+    Entry& entry = entries[index];
+    unsigned width = entry.size.x + 2 * Padding;
+    unsigned height = entry.size.y + 2 * Padding;
+
+    if (shelfX + width > AtlasWidth) {
+      shelfY += shelfHeight;
+      shelfX = 0;
+      shelfHeight = 0;
+    }
+
+    entry.position = { shelfX + Padding, shelfY + Padding };
+    shelfX += width;
+    shelfHeight = std::max(shelfHeight, height);
+  }
+
+  const unsigned atlasHeight = nextPowerOfTwo(shelfY + shelfHeight);
+
+  std::vector<uint8_t> pixels(static_cast<std::size_t>(AtlasWidth) * atlasHeight * 4, 0);
+
+  for (auto& entry : entries) {
+    blit(pixels, AtlasWidth, entry);
+  }
+
+  gf::Image atlas;
+  atlas.create({ AtlasWidth, atlasHeight }, pixels.data());
+
+  if (!atlas.saveToFile(imageOutput)) {
+    std::cerr << "Could not save the atlas: '" << imageOutput << "'\n";
+    return 1;
+  }
+
+  std::ofstream header(headerOutput);
+
+  if (!header) {
+    std::cerr << "Could not write the header: '" << headerOutput << "'\n";
+    return 1;
+  }
+
+  header << "// Generated by krokodile-atlas, do not edit.\n";
+  header << "#ifndef KKD_ATLAS_REGIONS_H\n";
+  header << "#define KKD_ATLAS_REGIONS_H\n\n";
+  header << "#include <cstddef>\n\n";
+  header << "namespace kkd {\n";
+  header << "  enum class AtlasRegion : std::size_t {\n";
+
+  for (auto& entry : entries) {
+    header << "    " << entry.name << ",\n";
+  }
+
+  header << "  };\n\n";
+  header << "  struct AtlasRegionData {\n";
+  header << "    float left; // normalized texture coordinates\n";
+  header << "    float top;\n";
+  header << "    float width;\n";
+  header << "    float height;\n";
+  header << "    unsigned pixelWidth;\n";
+  header << "    unsigned pixelHeight;\n";
+  header << "  };\n\n";
+  header << "  constexpr const char *AtlasTextureName = \"atlas.png\";\n";
+  header << "  constexpr unsigned AtlasWidth = " << AtlasWidth << ";\n";
+  header << "  constexpr unsigned AtlasHeight = " << atlasHeight << ";\n";
+  header << "  constexpr std::size_t AtlasRegionCount = " << entries.size() << ";\n\n";
+  header << "  constexpr AtlasRegionData AtlasRegions[AtlasRegionCount] = {\n";
+
+  for (auto& entry : entries) {
+    header << "    { "
+      << entry.position.x << ".0f / AtlasWidth, "
+      << entry.position.y << ".0f / AtlasHeight, "
+      << entry.size.x << ".0f / AtlasWidth, "
+      << entry.size.y << ".0f / AtlasHeight, "
+      << entry.size.x << ", " << entry.size.y << " }, // " << entry.name << "\n";
+  }
+
+  header << "  };\n";
+  header << "}\n\n";
+  header << "#endif // KKD_ATLAS_REGIONS_H\n";
+
+  return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gf/Heightmap.h>
+#include <gf/Noises.h>
+#include <gf/Random.h>
+#include <gf/Time.h>
+
+#include "local/AllocationTracker.h"
+#include "local/Heightfield.h"
+#include "local/KreatureContainer.h"
+#include "local/Messages.h"
+#include "local/PerlinField.h"
+#include "local/Random.h"
+#include "local/RandomStream.h"
+#include "local/Singletons.h"
+
+// Headless simulation benchmark: runs KreatureContainer::update() with a
+// fixed seed and a fixed time step, without opening a window.
+//
+// Usage: krokodile-bench [--ticks N] [--warmup N] [--seed S] [--step SECONDS] [--threads N] [--draws N] [--map SIZE] [POPULATION...]
+//
+// It also compares the speed of the random generators, and with --map, the
+// generation of a SIZE * SIZE map with gf::Heightmap and with kkd::Heightfield.
+//
+// Built with KROKODILE_TRACK_ALLOCATIONS, it counts the heap allocations
+// of the measured ticks.
+
+namespace {
+  struct Options {
+    std::vector<std::size_t> populations;
+    unsigned ticks = 2000;
+    unsigned warmup = 100;
+    unsigned long long seed = 42;
+    float step = 1.0f / 60.0f;
+    unsigned threads = 0; // one per core
+    unsigned long draws = 10000000;
+    int map = 0; // no map generation
+  };
+
+  void printUsage(const char *program) {
+    std::fprintf(stderr, "Usage: %s [--ticks N] [--warmup N] [--seed S] [--step SECONDS] [--threads N] [--draws N] [--map SIZE] [POPULATION...]\n", program);
+  }
+
+  bool parseOptions(int argc, char *argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+      const char *arg = argv[i];
+      bool hasValue = i + 1 < argc;
+
+      if (std::strcmp(arg, "--ticks") == 0 && hasValue) {
+        options.ticks = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--warmup") == 0 && hasValue) {
+        options.warmup = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+        options.seed = std::strtoull(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--step") == 0 && hasValue) {
+        options.step = std::strtof(argv[++i], nullptr);
+      } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+        options.threads = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--draws") == 0 && hasValue) {
+        options.draws = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--map") == 0 && hasValue) {
+        options.map = std::atoi(argv[++i]);
+      } else if (arg[0] != '-') {
+        options.populations.push_back(std::strtoul(arg, nullptr, 10));
+      } else {
+        return false;
+      }
+    }
+
+    if (options.populations.empty()) {
+      options.populations = { 25, 1000, 10000, 100000 };
+    }
+
+    return options.ticks > 0 && options.step > 0.0f && options.map >= 0;
+  }
+
+  std::size_t takeAllocationCount() {
+    std::size_t count = 0;
+
+    for (std::size_t i = 0; i < kkd::SubsystemCount; ++i) {
+      count += kkd::AllocationTracker::takeStats(static_cast<kkd::Subsystem>(i)).count;
+    }
+
+    return count;
+  }
+
+  double percentile(const std::vector<double>& sorted, double ratio) {
+    std::size_t index = static_cast<std::size_t>(ratio * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+  }
+
+  void runBenchmark(const Options& options, std::size_t population) {
+    // fresh singletons for every run, so that every run is reproducible
+    gf::SingletonStorage<kkd::MessageBus> storageForMessageBus(kkd::gMessageBus);
+    gf::SingletonStorage<kkd::Random> storageForRandom(kkd::gRandom, options.seed);
+
+    kkd::KreatureContainer kreatures(population);
+
+    kkd::ViewSize view;
+    view.viewSize = { 1000.0f, 1000.0f };
+    view.viewCenter = { 0.0f, 0.0f };
+    kkd::gMessageBus().send(view);
+
+    const gf::Time step = gf::seconds(options.step);
+    std::vector<double> latencies;
+    latencies.reserve(options.ticks);
+    std::size_t maxQueueDepth = 0;
+    std::size_t allocations = 0;
+
+    for (unsigned tick = 0; tick < options.warmup + options.ticks; ++tick) {
+      if (tick == options.warmup) {
+        takeAllocationCount();
+      }
+
+      // the player keeps walking in circles
+      kreatures.playerForwardMove(1);
+      kreatures.playerSidedMove(tick % 120 < 60 ? 1 : -1);
+
+      auto start = std::chrono::steady_clock::now();
+      kreatures.update(step);
+      auto end = std::chrono::steady_clock::now();
+
+      kkd::gMessageBus().dispatch();
+
+      if (tick >= options.warmup) {
+        latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        maxQueueDepth = std::max(maxQueueDepth, kreatures.getSpawnQueueDepth());
+      }
+    }
+
+    allocations = takeAllocationCount();
+
+    double total = 0.0;
+
+    for (auto latency : latencies) {
+      total += latency;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    char allocationText[32] = "-";
+
+    if (kkd::AllocationTracker::isEnabled()) {
+      std::snprintf(allocationText, sizeof(allocationText), "%zu", allocations);
+    }
+
+    std::printf("%10zu %12.1f %10.1f %10.1f %10.1f %10.1f %11zu %11s\n",
+      population,
+      latencies.size() / (total / 1e6),
+      percentile(latencies, 0.50),
+      percentile(latencies, 0.90),
+      percentile(latencies, 0.99),
+      latencies.back(),
+      maxQueueDepth,
+      allocationText
+    );
+  }
+
+  template<typename Generator>
+  void runRandomBenchmark(const char *name, Generator& generator, unsigned long draws) {
+    float sum = 0.0f; // so that the draws are not optimized away
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned long i = 0; i < draws; ++i) {
+      sum += generator.computeUniformFloat(0.0f, 1.0f);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double total = std::chrono::duration<double, std::nano>(end - start).count();
+
+    std::printf("%-14s %10.2f ns/draw (sum: %g)\n", name, total / draws, sum);
+  }
+
+  // the generation of the original map, and the tile as it was computed
+  constexpr double MapScale = 2.0;
+  constexpr int MapTileTypes = 4;
+
+  void runMapBenchmark(const Options& options) {
+    const uint32_t seed = static_cast<uint32_t>(options.seed);
+    const int size = options.map;
+    std::vector<uint8_t> expected(static_cast<std::size_t>(size) * size);
+    std::vector<uint8_t> actual(expected.size());
+
+    auto start = std::chrono::steady_clock::now();
+
+    gf::Random referenceRandom(seed);
+    gf::PerlinNoise2D noise(referenceRandom, MapScale);
+    gf::Heightmap heightmap({ size, size });
+    heightmap.reset();
+    heightmap.addNoise(noise);
+    heightmap.normalize();
+
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        expected[static_cast<std::size_t>(y) * size + x] = static_cast<uint8_t>(heightmap.getValue({ x, y }) * (MapTileTypes - 0.000001));
+      }
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+
+    gf::Random random(seed);
+    kkd::PerlinField field(random, MapScale);
+    kkd::Heightfield heightfield({ size, size });
+    heightfield.setNoise(field);
+    heightfield.normalize();
+    heightfield.computeTiles(MapTileTypes, actual.data());
+
+    auto end = std::chrono::steady_clock::now();
+
+    std::size_t mismatches = 0;
+
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      if (expected[i] != actual[i]) {
+        ++mismatches;
+      }
+    }
+
+    std::printf("%-14s %10.1f ms\n", "gf::Heightmap", std::chrono::duration<double, std::milli>(middle - start).count());
+    std::printf("%-14s %10.1f ms\n", "Heightfield", std::chrono::duration<double, std::milli>(end - middle).count());
+    std::printf("%zu tiles differ\n", mismatches);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+
+  if (!parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  gf::SingletonStorage<gf::ResourceManager> storageForResourceManager(kkd::gResourceManager);
+  gf::SingletonStorage<kkd::WorkerPool> storageForWorkerPool(kkd::gWorkerPool, options.threads);
+
+  std::printf("seed: %llu, step: %g s, ticks: %u (+%u warmup), threads: %zu\n", options.seed, options.step, options.ticks, options.warmup, kkd::gWorkerPool().getThreadCount());
+  std::printf("%10s %12s %10s %10s %10s %10s %11s %11s\n", "population", "ticks/s", "p50 (us)", "p90 (us)", "p99 (us)", "max (us)", "spawn queue", "allocations");
+
+  for (auto population : options.populations) {
+    runBenchmark(options, population);
+  }
+
+  if (options.draws > 0) {
+    std::printf("\ncomputeUniformFloat, %lu draws\n", options.draws);
+
+    gf::Random mersenneTwister(static_cast<uint32_t>(options.seed));
+    runRandomBenchmark("gf::Random", mersenneTwister, options.draws);
+
+    kkd::Random xoshiro(options.seed);
+    runRandomBenchmark("kkd::Random", xoshiro, options.draws);
+
+    kkd::RandomStream stream(options.seed, 0, 0);
+    runRandomBenchmark("RandomStream", stream, options.draws);
+  }
+
+  if (options.map > 0) {
+    std::printf("\nmap generation, %dx%d tiles, seed %u\n", options.map, options.map, static_cast<uint32_t>(options.seed));
+    runMapBenchmark(options);
+  }
+
+  return 0;
+}
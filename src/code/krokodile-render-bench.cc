@@ -0,0 +1,317 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gf/EntityContainer.h>
+#include <gf/Image.h>
+#include <gf/Math.h>
+#include <gf/RenderTexture.h>
+#include <gf/ViewContainer.h>
+#include <gf/Views.h>
+#include <gf/Window.h>
+
+#include "config.h"
+#include "local/FixedTimestep.h"
+#include "local/Hud.h"
+#include "local/KreatureContainer.h"
+#include "local/Map.h"
+#include "local/Messages.h"
+#include "local/RandomStream.h"
+#include "local/Singletons.h"
+
+// Offscreen rendering benchmark: renders the map, the kreatures and the
+// hud in a render texture, without vertical synchronization nor frame
+// limit, while the camera goes around the world.
+//
+// Usage: krokodile-render-bench [--frames N] [--warmup N] [--seed S] [--size WxH] [--population N] [--dump FILE] [--golden FILE] [--tolerance N]
+//
+// The submit time is the time spent in the render calls on the CPU, the
+// frame time includes the display of the render texture. The last frame
+// can be saved with --dump, or compared with a reference image with
+// --golden; it is then rendered once all the visible chunks are loaded.
+// It returns 2 when the image differs from the reference.
+
+namespace {
+  struct Options {
+    unsigned frames = 600;
+    unsigned warmup = 60;
+    unsigned long long seed = 42;
+    gf::Vector2u size = { 1024, 576 };
+    std::size_t population = 1000;
+    std::string dump;
+    std::string golden;
+    int tolerance = 8; // per channel
+  };
+
+  void printUsage(const char *program) {
+    std::fprintf(stderr, "Usage: %s [--frames N] [--warmup N] [--seed S] [--size WxH] [--population N] [--dump FILE] [--golden FILE] [--tolerance N]\n", program);
+  }
+
+  bool parseOptions(int argc, char *argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+      const char *arg = argv[i];
+      bool hasValue = i + 1 < argc;
+
+      if (std::strcmp(arg, "--frames") == 0 && hasValue) {
+        options.frames = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--warmup") == 0 && hasValue) {
+        options.warmup = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+        options.seed = std::strtoull(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--size") == 0 && hasValue) {
+        unsigned width = 0;
+        unsigned height = 0;
+
+        if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) {
+          return false;
+        }
+
+        options.size = { width, height };
+      } else if (std::strcmp(arg, "--population") == 0 && hasValue) {
+        options.population = std::strtoul(argv[++i], nullptr, 10);
+      } else if (std::strcmp(arg, "--dump") == 0 && hasValue) {
+        options.dump = argv[++i];
+      } else if (std::strcmp(arg, "--golden") == 0 && hasValue) {
+        options.golden = argv[++i];
+      } else if (std::strcmp(arg, "--tolerance") == 0 && hasValue) {
+        options.tolerance = std::atoi(argv[++i]);
+      } else {
+        return false;
+      }
+    }
+
+    return options.frames > 0 && options.size.x > 0 && options.size.y > 0 && options.population > 0;
+  }
+
+  double percentile(const std::vector<double>& sorted, double ratio) {
+    std::size_t index = static_cast<std::size_t>(ratio * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+  }
+
+  void printLatencies(const char *name, std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-12s %10.1f %10.1f %10.1f %10.1f\n", name, percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99), latencies.back());
+  }
+
+  // the number of pixels that differ by more than tolerance on a channel
+  std::size_t compareImages(const gf::Image& lhs, const gf::Image& rhs, int tolerance) {
+    if (lhs.getSize() != rhs.getSize()) {
+      return static_cast<std::size_t>(-1);
+    }
+
+    const uint8_t *lhsPixels = lhs.getPixelsPtr();
+    const uint8_t *rhsPixels = rhs.getPixelsPtr();
+    std::size_t count = static_cast<std::size_t>(lhs.getSize().x) * lhs.getSize().y;
+    std::size_t differences = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      for (std::size_t channel = 0; channel < 4; ++channel) {
+        if (std::abs(lhsPixels[4 * i + channel] - rhsPixels[4 * i + channel]) > tolerance) {
+          ++differences;
+          break;
+        }
+      }
+    }
+
+    return differences;
+  }
+
+  // the camera goes once around the world during the measured frames
+  constexpr float CameraRadius = 1000.0f;
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+
+  if (!parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  gf::SingletonStorage<gf::ResourceManager> storageForResourceManager(kkd::gResourceManager);
+  kkd::gResourceManager().addSearchDir(KROKODILE_DATA_DIR);
+  kkd::gResourceManager().addSearchDir("krokodile");
+
+  gf::SingletonStorage<kkd::MessageBus> storageForMessageBus(kkd::gMessageBus);
+  gf::SingletonStorage<kkd::Random> storageForRandom(kkd::gRandom, options.seed);
+  gf::SingletonStorage<kkd::WorkerPool> storageForWorkerPool(kkd::gWorkerPool);
+  gf::SingletonStorage<kkd::FrameArena> storageForFrameArena(kkd::gFrameArena);
+
+  // the window only provides the OpenGL context
+  gf::Window window("Krokodile render benchmark", options.size);
+  window.setVisible(false);
+  window.setVerticalSyncEnabled(false);
+  window.setFramerateLimit(0);
+
+  gf::RenderTexture target(options.size);
+
+  gf::ViewContainer views;
+  gf::ExtendView mainView({ 0.0f, 0.0f }, { 1000.0f, 1000.0f });
+  views.addView(mainView);
+
+  gf::ScreenView hudView;
+  views.addView(hudView);
+  views.setInitialScreenSize(options.size);
+
+  // the same entities as the game
+  gf::EntityContainer mainEntities;
+
+  kkd::Map map(static_cast<uint32_t>(kkd::RandomStream(options.seed, 0, 0).computeNext()));
+  mainEntities.addEntity(map);
+
+  kkd::KreatureContainer kreatures(options.population);
+  mainEntities.addEntity(kreatures);
+
+  gf::EntityContainer hudEntities;
+
+  kkd::Hud hud;
+  hudEntities.addEntity(hud);
+
+  const bool needsImage = !options.dump.empty() || !options.golden.empty();
+  const unsigned frameCount = options.warmup + options.frames;
+
+  std::vector<double> submitTimes;
+  std::vector<double> frameTimes;
+  submitTimes.reserve(options.frames);
+  frameTimes.reserve(options.frames);
+  std::size_t drawCalls = 0; // map and kreatures
+  std::size_t vertices = 0; // map and kreatures
+  std::size_t hudDrawables = 0; // a text or a shape may issue several draw calls
+  std::size_t hudRebuilds = 0;
+
+  std::printf("seed: %llu, size: %ux%u, population: %zu, frames: %u (+%u warmup)\n", options.seed, options.size.x, options.size.y, options.population, options.frames, options.warmup);
+
+  for (unsigned frame = 0; frame < frameCount; ++frame) {
+    kkd::gFrameArena().reset();
+
+    // the scripted camera, and the player walking in circles; the warmup
+    // frames lead to the start of the turn
+    float angle = 2.0f * gf::Pi * (static_cast<float>(frame) - options.warmup) / options.frames;
+    mainView.setCenter({ CameraRadius * std::cos(angle), CameraRadius * std::sin(angle) });
+
+    kkd::ViewSize message;
+    message.viewSize = mainView.getSize();
+    message.viewCenter = mainView.getCenter();
+    kkd::gMessageBus().post(message);
+
+    kreatures.playerForwardMove(1);
+    kreatures.playerSidedMove(frame % 120 < 60 ? 1 : -1);
+    kkd::gMessageBus().dispatch();
+
+    bool isLastFrame = frame + 1 == frameCount;
+
+    // the reference image does not depend on the speed of the chunk generation
+    if (isLastFrame && needsImage) {
+      for (;;) {
+        map.update(kkd::SimulationStep);
+
+        if (map.getPendingChunkCount() == 0) {
+          break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+      hud.reset();
+    }
+
+    mainEntities.update(kkd::SimulationStep);
+    hudEntities.update(kkd::SimulationStep);
+    kkd::gMessageBus().dispatch();
+
+    // the measured part
+    auto start = std::chrono::steady_clock::now();
+
+    target.clear();
+    target.setView(mainView);
+    mainEntities.render(target);
+    target.setView(hudView);
+    hudEntities.render(target);
+
+    auto middle = std::chrono::steady_clock::now();
+    target.display();
+    auto end = std::chrono::steady_clock::now();
+
+    if (frame >= options.warmup) {
+      submitTimes.push_back(std::chrono::duration<double, std::micro>(middle - start).count());
+      frameTimes.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+      drawCalls += map.getSubmittedChunkCount() + kreatures.getDrawCallCount();
+      hudDrawables += hud.getDrawCallCount();
+      vertices += map.getSubmittedVertexCount() + kreatures.getVertexCount();
+      hudRebuilds += hud.getRebuildCount();
+    }
+  }
+
+  double totalTime = 0.0;
+
+  for (auto time : frameTimes) {
+    totalTime += time;
+  }
+
+  std::printf("%.1f frames/s, %.1f draw calls/frame and %.0f vertices/frame (map and kreatures), %.1f hud drawables/frame\n",
+    frameTimes.size() / (totalTime / 1e6), static_cast<double>(drawCalls) / options.frames, static_cast<double>(vertices) / options.frames, static_cast<double>(hudDrawables) / options.frames);
+  std::printf("hud rebuilds: %zu in %u frames\n", hudRebuilds, options.frames);
+  std::printf("%-12s %10s %10s %10s %10s\n", "", "p50 (us)", "p90 (us)", "p99 (us)", "max (us)");
+  printLatencies("submit", submitTimes);
+  printLatencies("frame", frameTimes);
+
+  if (!needsImage) {
+    return 0;
+  }
+
+  gf::Image image = target.capture();
+
+  if (!options.dump.empty()) {
+    if (!image.saveToFile(options.dump)) {
+      std::fprintf(stderr, "Could not write %s\n", options.dump.c_str());
+      return 1;
+    }
+
+    std::printf("last frame written to %s\n", options.dump.c_str());
+  }
+
+  if (!options.golden.empty()) {
+    gf::Image reference;
+
+    if (!reference.loadFromFile(options.golden)) {
+      std::fprintf(stderr, "Could not read %s\n", options.golden.c_str());
+      return 1;
+    }
+
+    std::size_t differences = compareImages(image, reference, options.tolerance);
+
+    if (differences == static_cast<std::size_t>(-1)) {
+      std::printf("golden image: the size differs from %s\n", options.golden.c_str());
+      return 2;
+    }
+
+    std::printf("golden image: %zu pixels differ from %s\n", differences, options.golden.c_str());
+    return differences == 0 ? 0 : 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <gf/Vector.h>
+
+#include "local/FixedTimestep.h"
+#include "local/InputRecord.h"
+#include "local/KreatureContainer.h"
+#include "local/Messages.h"
+#include "local/Random.h"
+#include "local/Singletons.h"
+
+// Headless replay of a session recorded with `krokodile --record FILE`:
+// the input frames are fed to KreatureContainer as in the game loop, as
+// fast as possible and without a window. The hash of the kreatures at the
+// end is compared with the one of the recording.
+//
+// Usage: krokodile-replay [--threads N] FILE
+//
+// It returns 0 when the hashes match, 2 when they differ, 1 on error.
+
+namespace {
+  void printUsage(const char *program) {
+    std::fprintf(stderr, "Usage: %s [--threads N] FILE\n", program);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  unsigned threads = 0; // one per core
+  const char *filename = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (argv[i][0] != '-' && filename == nullptr) {
+      filename = argv[i];
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (filename == nullptr) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  kkd::InputReplay replay;
+
+  if (!replay.open(filename)) {
+    std::fprintf(stderr, "Could not read the session in %s\n", filename);
+    return 1;
+  }
+
+  gf::SingletonStorage<gf::ResourceManager> storageForResourceManager(kkd::gResourceManager);
+  gf::SingletonStorage<kkd::MessageBus> storageForMessageBus(kkd::gMessageBus);
+  gf::SingletonStorage<kkd::Random> storageForRandom(kkd::gRandom, replay.getSeed());
+  gf::SingletonStorage<kkd::WorkerPool> storageForWorkerPool(kkd::gWorkerPool, threads);
+  gf::SingletonStorage<kkd::FrameArena> storageForFrameArena(kkd::gFrameArena);
+
+  // the part of the game loop that changes the simulation
+  bool isGameComplete = false;
+  gf::Vector2f viewSize(0.0f, 0.0f);
+  gf::Vector2f viewCenter(0.0f, 0.0f);
+
+  kkd::gMessageBus().subscribe<kkd::CompleteGame>([&isGameComplete](const kkd::CompleteGame&) {
+    isGameComplete = true;
+  });
+
+  kkd::gMessageBus().subscribe<kkd::KrokodilePosition>([&viewCenter](const kkd::KrokodilePosition& message) {
+    viewCenter = message.position;
+  });
+
+  kkd::KreatureContainer kreatures;
+  kkd::FixedTimestep timestep(kkd::SimulationStep, kkd::MaxSimulationSteps);
+
+  uint64_t frames = 0;
+  uint64_t ticks = 0;
+  kkd::InputFrame input;
+
+  auto start = std::chrono::steady_clock::now();
+
+  while (replay.next(input)) {
+    kkd::gFrameArena().reset();
+
+    if (input.hasViewSize) {
+      viewSize = input.viewSize;
+    }
+
+    kkd::ViewSize message;
+    message.viewSize = viewSize;
+    message.viewCenter = viewCenter;
+    kkd::gMessageBus().post(message);
+
+    kkd::applyPlayerInput(input, kreatures);
+
+    if (input.fusion) {
+      if (isGameComplete) {
+        kreatures.resetKreatures();
+        isGameComplete = false;
+      } else {
+        kreatures.fusionDNA();
+      }
+    }
+
+    if (input.krokodile) {
+      kreatures.createKrokodile();
+    }
+
+    kkd::gMessageBus().dispatch();
+
+    if (!isGameComplete) {
+      int steps = timestep.advance(input.time);
+
+      for (int i = 0; i < steps; ++i) {
+        kreatures.update(timestep.getStep());
+      }
+
+      kreatures.setInterpolation(timestep.getInterpolation());
+      ticks += steps;
+    }
+
+    kkd::gMessageBus().dispatch();
+    ++frames;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  if (!replay.isComplete()) {
+    std::fprintf(stderr, "The session in %s is truncated after %" PRIu64 " frames\n", filename, frames);
+    return 1;
+  }
+
+  uint64_t hash = kreatures.computeStateHash();
+  bool match = frames == replay.getFrameCount() && hash == replay.getStateHash();
+
+  std::printf("seed: %" PRIu64 ", frames: %" PRIu64 ", ticks: %" PRIu64 ", threads: %zu\n", replay.getSeed(), frames, ticks, kkd::gWorkerPool().getThreadCount());
+  std::printf("time: %.3f s, %.1f us/frame, %.1f ticks/s\n", seconds, frames > 0 ? seconds * 1e6 / frames : 0.0, seconds > 0.0 ? ticks / seconds : 0.0);
+  std::printf("state: %016" PRIx64 ", recorded: %016" PRIx64 ", %s\n", hash, replay.getStateHash(), match ? "match" : "MISMATCH");
+
+  return match ? 0 : 2;
+}
@@ -16,6 +16,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 #include <gf/Anchor.h>
 #include <gf/Action.h>
@@ -34,13 +36,22 @@
 #include <gf/Window.h>
 
 #include <iostream>
+#include <string>
 
 #include "config.h"
+#include "local/AllocationTracker.h"
+#include "local/FixedTimestep.h"
+#include "local/FlightRecorder.h"
+#include "local/FrameArena.h"
+#include "local/FrameProfiler.h"
 #include "local/Hud.h"
+#include "local/InputRecord.h"
 #include "local/KonamiGamepadControl.h"
 #include "local/KreatureContainer.h"
 #include "local/Map.h"
 #include "local/Messages.h"
+#include "local/ProfilerOverlay.h"
+#include "local/RandomStream.h"
 #include "local/Singletons.h"
 
 #define UNUSED(x) (void)(x)
@@ -56,31 +67,52 @@ void konamiTriggered() {
   }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  // Usage: krokodile [--hitch-threshold MILLISECONDS] [--seed S] [--record FILE]
+  float hitchThreshold = 50.0f; // 0 to disable the hitch dumps
+  uint64_t seed = kkd::Random::seedFromDevice();
+  std::string recordFilename;
+
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+
+    if (std::strcmp(argv[i], "--hitch-threshold") == 0 && hasValue) {
+      hitchThreshold = std::strtof(argv[++i], nullptr);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--record") == 0 && hasValue) {
+      recordFilename = argv[++i];
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--hitch-threshold MILLISECONDS] [--seed S] [--record FILE]" << std::endl;
+      return 1;
+    }
+  }
+
   bool isGameComplete = false;
   int nbGen = 0;
 
   static constexpr gf::Vector2u ScreenSize(1024, 576);
   static constexpr gf::Vector2f ViewSize(1000.0f, 1000.0f); // dummy values
   static constexpr gf::Vector2f ViewCenter(0.0f, 0.0f); // dummy values
+  static constexpr const char *TraceFilename = "krokodile-trace.json";
 
   // Set the singletons
   gf::SingletonStorage<gf::ResourceManager> storageForResourceManager(kkd::gResourceManager);
   kkd::gResourceManager().addSearchDir(KROKODILE_DATA_DIR);
   kkd::gResourceManager().addSearchDir("krokodile");
 
-  gf::SingletonStorage<gf::MessageManager> storageForMessageManager(kkd::gMessageManager);
-  gf::SingletonStorage<gf::Random> storageForRandom(kkd::gRandom);
+  gf::SingletonStorage<kkd::MessageBus> storageForMessageBus(kkd::gMessageBus);
+  gf::SingletonStorage<kkd::Random> storageForRandom(kkd::gRandom, seed);
+  gf::SingletonStorage<kkd::WorkerPool> storageForWorkerPool(kkd::gWorkerPool);
+  gf::SingletonStorage<kkd::FrameArena> storageForFrameArena(kkd::gFrameArena);
 
   gf::Clock startClock;
   float endTime;
-  kkd::gMessageManager().registerHandler<kkd::CompleteGame>(
-      [&isGameComplete, &startClock, &endTime](gf::Id type, gf::Message *msg) {
-        assert(type == kkd::CompleteGame::type);
+  kkd::gMessageBus().subscribe<kkd::CompleteGame>(
+      [&isGameComplete, &startClock, &endTime](const kkd::CompleteGame& msg) {
         UNUSED(msg);
         isGameComplete = true;
         endTime = startClock.getElapsedTime().asSeconds();
-        return gf::MessageStatus::Keep;
   });
 
   // initialization
@@ -100,11 +132,8 @@ int main() {
   views.addView(hudView);
   views.setInitialScreenSize(ScreenSize);
 
-  kkd::gMessageManager().registerHandler<kkd::KrokodilePosition>([&mainView](gf::Id type, gf::Message *msg) {
-    assert(type == kkd::KrokodilePosition::type);
-    auto positionKrokodileMessage = static_cast<kkd::KrokodilePosition*>(msg);
-    mainView.setCenter(positionKrokodileMessage->position);
-    return gf::MessageStatus::Keep;
+  kkd::gMessageBus().subscribe<kkd::KrokodilePosition>([&mainView](const kkd::KrokodilePosition& positionKrokodileMessage) {
+    mainView.setCenter(positionKrokodileMessage.position);
   });
 
   // actions
@@ -156,6 +185,14 @@ int main() {
   sprintAction.setContinuous();
   actions.addAction(sprintAction);
 
+  gf::Action profilerAction("Profiler");
+  profilerAction.addKeycodeKeyControl(gf::Keycode::F3);
+  actions.addAction(profilerAction);
+
+  gf::Action captureAction("Profiler capture");
+  captureAction.addKeycodeKeyControl(gf::Keycode::F4);
+  actions.addAction(captureAction);
+
   //Konami
   gf::KonamiKeyboardControl konami;
   kkd::KonamiGamepadControl koko;
@@ -165,27 +202,25 @@ int main() {
   easterEgg.setInstantaneous();
   actions.addAction(easterEgg);
 
-  kkd::gMessageManager().registerHandler<kkd::GamepadConnected>(
+  kkd::gMessageBus().subscribe<kkd::GamepadConnected>(
     [&closeWindowAction, &fullscreenAction, &leftAction, &rightAction, &upAction, &downAction, &swapAction, &fusionAction, &sprintAction, &konami]
-    (gf::Id type, gf::Message *msg) {
-      assert(type == kkd::GamepadConnected::type);
-      auto gamepadMsg = static_cast<kkd::GamepadConnected*>(msg);
-      closeWindowAction.addGamepadButtonControl(gamepadMsg->gamepadId, gf::GamepadButton::Back);
-      fullscreenAction.addGamepadButtonControl(gamepadMsg->gamepadId, gf::GamepadButton::Start);
-      leftAction.addGamepadAxisControl(gamepadMsg->gamepadId, gf::GamepadAxis::RightX, gf::GamepadAxisDirection::Negative);
-      rightAction.addGamepadAxisControl(gamepadMsg->gamepadId, gf::GamepadAxis::RightX, gf::GamepadAxisDirection::Positive);
-      upAction.addGamepadAxisControl(gamepadMsg->gamepadId, gf::GamepadAxis::LeftY, gf::GamepadAxisDirection::Negative);
-      downAction.addGamepadAxisControl(gamepadMsg->gamepadId, gf::GamepadAxis::LeftY, gf::GamepadAxisDirection::Positive);
-      swapAction.addGamepadButtonControl(gamepadMsg->gamepadId, gf::GamepadButton::X);
-      fusionAction.addGamepadButtonControl(gamepadMsg->gamepadId, gf::GamepadButton::LeftBumper);
-      sprintAction.addGamepadButtonControl(gamepadMsg->gamepadId, gf::GamepadButton::RightBumper);
-      return gf::MessageStatus::Keep;
+    (const kkd::GamepadConnected& gamepadMsg) {
+      closeWindowAction.addGamepadButtonControl(gamepadMsg.gamepadId, gf::GamepadButton::Back);
+      fullscreenAction.addGamepadButtonControl(gamepadMsg.gamepadId, gf::GamepadButton::Start);
+      leftAction.addGamepadAxisControl(gamepadMsg.gamepadId, gf::GamepadAxis::RightX, gf::GamepadAxisDirection::Negative);
+      rightAction.addGamepadAxisControl(gamepadMsg.gamepadId, gf::GamepadAxis::RightX, gf::GamepadAxisDirection::Positive);
+      upAction.addGamepadAxisControl(gamepadMsg.gamepadId, gf::GamepadAxis::LeftY, gf::GamepadAxisDirection::Negative);
+      downAction.addGamepadAxisControl(gamepadMsg.gamepadId, gf::GamepadAxis::LeftY, gf::GamepadAxisDirection::Positive);
+      swapAction.addGamepadButtonControl(gamepadMsg.gamepadId, gf::GamepadButton::X);
+      fusionAction.addGamepadButtonControl(gamepadMsg.gamepadId, gf::GamepadButton::LeftBumper);
+      sprintAction.addGamepadButtonControl(gamepadMsg.gamepadId, gf::GamepadButton::RightBumper);
   });
 
   // entities
   gf::EntityContainer mainEntities;
 
-  kkd::Map map;
+  // the map has its own stream, gRandom is left to the simulation
+  kkd::Map map(static_cast<uint32_t>(kkd::RandomStream(seed, 0, 0).computeNext()));
   mainEntities.addEntity(map);
 
   kkd::KreatureContainer kreatures;
@@ -197,41 +232,77 @@ int main() {
   kkd::Hud hud;
   hudEntities.addEntity(hud);
 
-  // game loop
+  kkd::ProfilerOverlay profilerOverlay(hud);
+  hudEntities.addEntity(profilerOverlay);
+
+  // input recording, to be played with krokodile-replay
+  kkd::InputRecorder inputRecorder;
+
+  if (!recordFilename.empty() && !inputRecorder.open(recordFilename, seed)) {
+    std::cerr << "Could not write " << recordFilename << std::endl;
+  }
+
+  gf::Vector2f recordedViewSize(0.0f, 0.0f);
+
+  // the score screen, set when the game is complete
+  gf::Text scoreTxt;
+  scoreTxt.setFont(kkd::gResourceManager().getFont("blkchcry.ttf"));
+  scoreTxt.setCharacterSize(100);
+  scoreTxt.setOutlineColor(gf::Color::Black);
+  scoreTxt.setOutlineThickness(2.0f);
+  scoreTxt.setColor(gf::Color::White);
+  scoreTxt.setParagraphWidth(1000.0f);
+  scoreTxt.setAlignment(gf::Alignment::Center);
+  bool isScoreUpToDate = false;
+
   renderer.clear(gf::Color::lighter(gf::Color::Chartreuse));
+  // game loop
   gf::Clock clock;
+  kkd::FixedTimestep timestep(kkd::SimulationStep, kkd::MaxSimulationSteps);
+  kkd::AllocationReport allocationReport;
+  kkd::FlightRecorder flightRecorder(kreatures, hitchThreshold);
   while (window.isOpen()) {
+    kkd::FrameProfiler::beginFrame();
+    kkd::gFrameArena().reset();
+
+    // the allocations are charged to the input until the draw, except in
+    // the entities that charge their own subsystem
+    kkd::AllocationTracker::Scope inputAllocationScope(kkd::Subsystem::Input);
+
     // 1. input
-    gf::Event event;
-    while (window.pollEvent(event)) {
-      actions.processEvent(event);
-      views.processEvent(event);
-
-      switch (event.type) {
-        case gf::EventType::GamepadConnected:
-        {
-            gf::GamepadId id = gf::Gamepad::open(event.gamepadConnection.id);
-            kkd::GamepadConnected msg;
-            msg.gamepadId = id;
-            kkd::gMessageManager().sendMessage(&msg);
-            break;
-        }
-
-        case gf::EventType::GamepadDisconnected:
-        {
-            gf::Gamepad::close(event.gamepadDisconnection.id);
-            break;
-        }
-
-        default:
-            break;
-        }
+    {
+      kkd::FrameProfiler::Zone zone("input");
+      gf::Event event;
+      while (window.pollEvent(event)) {
+        actions.processEvent(event);
+        views.processEvent(event);
+
+        switch (event.type) {
+          case gf::EventType::GamepadConnected:
+          {
+              gf::GamepadId id = gf::Gamepad::open(event.gamepadConnection.id);
+              kkd::GamepadConnected msg;
+              msg.gamepadId = id;
+              kkd::gMessageBus().post(msg);
+              break;
+          }
+
+          case gf::EventType::GamepadDisconnected:
+          {
+              gf::Gamepad::close(event.gamepadDisconnection.id);
+              break;
+          }
+
+          default:
+              break;
+          }
+      }
     }
 
     kkd::ViewSize message;
     message.viewSize = mainView.getSize();
     message.viewCenter = mainView.getCenter();
-    kkd::gMessageManager().sendMessage(&message);
+    kkd::gMessageBus().post(message);
 
     if (closeWindowAction.isActive()) {
       window.close();
@@ -241,31 +312,36 @@ int main() {
       window.toggleFullscreen();
     }
 
-    // Movement
-    if (sprintAction.isActive()) {
-      kreatures.playerSprint(true);
-    }
-    else {
-      kreatures.playerSprint(false);
+    if (profilerAction.isActive()) {
+      profilerOverlay.toggle();
     }
 
-    if (rightAction.isActive()) {
-      kreatures.playerSidedMove(1);
-    } else if (leftAction.isActive()) {
-      kreatures.playerSidedMove(-1);
+    if (captureAction.isActive()) {
+      if (kkd::FrameProfiler::isCapturing()) {
+        kkd::FrameProfiler::stopCapture();
+        std::cout << "Profiler capture written to " << TraceFilename << std::endl;
+      } else if (!kkd::FrameProfiler::startCapture(TraceFilename)) {
+        std::cerr << "Could not write " << TraceFilename << std::endl;
+      }
     }
 
-    if (upAction.isActive()) {
-      kreatures.playerForwardMove(1);
-    } else if (downAction.isActive()) {
-      kreatures.playerForwardMove(-1);
-    }
+    // everything that changes the simulation goes through the input frame,
+    // so that it can be recorded
+    kkd::InputFrame input;
+    input.sprint = sprintAction.isActive();
+    input.side = rightAction.isActive() ? 1 : (leftAction.isActive() ? -1 : 0);
+    input.forward = upAction.isActive() ? 1 : (downAction.isActive() ? -1 : 0);
+    input.swap = swapAction.isActive();
+    input.fusion = fusionAction.isActive();
+    input.krokodile = easterEgg.isActive();
+    input.hasViewSize = message.viewSize != recordedViewSize;
+    input.viewSize = message.viewSize;
+    recordedViewSize = message.viewSize;
 
-    if (swapAction.isActive()) {
-      kreatures.swapKreature();
-    }
+    // Movement
+    kkd::applyPlayerInput(input, kreatures);
 
-    if (fusionAction.isActive()) {
+    if (input.fusion) {
       if (isGameComplete) {
         kreatures.resetKreatures();
         hud.reset();
@@ -273,26 +349,44 @@ int main() {
         nbGen = 0;
         startClock.restart();
         isGameComplete = false;
+        isScoreUpToDate = false;
       } else {
         kreatures.fusionDNA();
         nbGen++;
       }
     }
 
-    if (easterEgg.isActive()) {
+    if (input.krokodile) {
       kreatures.createKrokodile();
       konamiTriggered();
     }
 
+    // the messages of the input, before the update
+    kkd::gMessageBus().dispatch();
+
     // 2. update
-    gf::Time time = clock.restart();
+    input.time = clock.restart();
+    inputRecorder.record(input);
+
     if (!isGameComplete) {
-      // 2. update
-      mainEntities.update(time);
-      hudEntities.update(time);
+      // the simulation runs at a fixed rate, the rendering interpolates between the last two steps
+      int steps = timestep.advance(input.time);
+
+      for (int i = 0; i < steps; ++i) {
+        kkd::FrameProfiler::Zone zone("mainEntities.update");
+        mainEntities.update(timestep.getStep());
+      }
+
+      kreatures.setInterpolation(timestep.getInterpolation());
+      kkd::FrameProfiler::Zone zone("hudEntities.update");
+      hudEntities.update(input.time);
     }
 
+    // the messages of the update, before the draw
+    kkd::gMessageBus().dispatch();
+
     // 3. draw
+    kkd::AllocationTracker::Scope renderAllocationScope(kkd::Subsystem::Render);
     renderer.clear();
 
     if (!isGameComplete) {
@@ -307,22 +401,30 @@ int main() {
       gf::Coordinates coords(renderer);
       gf::Vector2f screenCenter = coords.getCenter();
 
-      int finalScore = (int)((10000.0f / (nbGen * endTime + 1)) * 1000.0f);
-      gf::Text scoreTxt("Generations : " + std::to_string(nbGen) + "\nTime : " + std::to_string((int)endTime) + " seconds\nScore : " + std::to_string(finalScore) + "\nPress 'Space' to restart", kkd::gResourceManager().getFont("blkchcry.ttf"), 100);
-      scoreTxt.setOutlineColor(gf::Color::Black);
-      scoreTxt.setOutlineThickness(2.0f);
-      scoreTxt.setColor(gf::Color::White);
-      scoreTxt.setPosition(screenCenter);
-      scoreTxt.setParagraphWidth(1000.0f);
-      scoreTxt.setAlignment(gf::Alignment::Center);
-      scoreTxt.setAnchor(gf::Anchor::Center);
+      if (!isScoreUpToDate) {
+        int finalScore = (int)((10000.0f / (nbGen * endTime + 1)) * 1000.0f);
+        scoreTxt.setString("Generations : " + std::to_string(nbGen) + "\nTime : " + std::to_string((int)endTime) + " seconds\nScore : " + std::to_string(finalScore) + "\nPress 'Space' to restart");
+        scoreTxt.setAnchor(gf::Anchor::Center);
+        isScoreUpToDate = true;
+      }
 
+      scoreTxt.setPosition(screenCenter);
       renderer.draw(scoreTxt);
     }
 
-    renderer.display();
+    {
+      kkd::FrameProfiler::Zone zone("renderer.display");
+      renderer.display();
+    }
+
     actions.reset();
     easterEgg.reset();
+    allocationReport.endFrame();
+    kkd::FrameProfiler::endFrame();
+    flightRecorder.endFrame();
   }
+
+  kkd::FrameProfiler::stopCapture();
+  inputRecorder.close(kreatures.computeStateHash());
   return 0;
 }
@@ -0,0 +1,179 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace kkd {
+
+  namespace {
+    // zero-initialized before any allocation
+    std::atomic<std::size_t> gAllocationCounts[SubsystemCount];
+    std::atomic<std::size_t> gAllocationBytes[SubsystemCount];
+    thread_local Subsystem gCurrentSubsystem = Subsystem::Other;
+
+#ifdef KKD_TRACK_ALLOCATIONS
+    void recordAllocation(std::size_t size) {
+      std::size_t index = static_cast<std::size_t>(gCurrentSubsystem);
+      gAllocationCounts[index].fetch_add(1, std::memory_order_relaxed);
+      gAllocationBytes[index].fetch_add(size, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+  const char *getSubsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+      case Subsystem::Other:
+        return "other";
+      case Subsystem::Input:
+        return "input";
+      case Subsystem::Kreatures:
+        return "kreatures";
+      case Subsystem::Map:
+        return "map";
+      case Subsystem::Hud:
+        return "hud";
+      case Subsystem::Render:
+        return "render";
+    }
+
+    return "?";
+  }
+
+  AllocationStats AllocationTracker::takeStats(Subsystem subsystem) {
+    std::size_t index = static_cast<std::size_t>(subsystem);
+    AllocationStats stats;
+    stats.count = gAllocationCounts[index].exchange(0, std::memory_order_relaxed);
+    stats.bytes = gAllocationBytes[index].exchange(0, std::memory_order_relaxed);
+    return stats;
+  }
+
+  AllocationTracker::Scope::Scope(Subsystem subsystem)
+  : m_previous(gCurrentSubsystem)
+  {
+    gCurrentSubsystem = subsystem;
+  }
+
+  AllocationTracker::Scope::~Scope() {
+    gCurrentSubsystem = m_previous;
+  }
+
+  AllocationReport::AllocationReport()
+  : m_frame(0)
+  , m_allocatingFrames(0)
+  {
+    // the allocations of the loading are not part of the first frame
+    for (std::size_t i = 0; i < SubsystemCount; ++i) {
+      AllocationTracker::takeStats(static_cast<Subsystem>(i));
+    }
+  }
+
+  AllocationReport::~AllocationReport() {
+    if (AllocationTracker::isEnabled()) {
+      std::fprintf(stderr, "allocations: %lu of %lu frames allocated\n", m_allocatingFrames, m_frame);
+    }
+  }
+
+  void AllocationReport::endFrame() {
+    ++m_frame;
+
+    if (!AllocationTracker::isEnabled()) {
+      return;
+    }
+
+    AllocationStats stats[SubsystemCount];
+    bool allocated = false;
+
+    for (std::size_t i = 0; i < SubsystemCount; ++i) {
+      stats[i] = AllocationTracker::takeStats(static_cast<Subsystem>(i));
+      allocated = allocated || stats[i].count > 0;
+    }
+
+    if (!allocated) {
+      return;
+    }
+
+    ++m_allocatingFrames;
+
+    // printed without allocating
+    std::fprintf(stderr, "frame %lu:", m_frame);
+
+    for (std::size_t i = 0; i < SubsystemCount; ++i) {
+      if (stats[i].count > 0) {
+        std::fprintf(stderr, " %s %zu (%zu B)", getSubsystemName(static_cast<Subsystem>(i)), stats[i].count, stats[i].bytes);
+      }
+    }
+
+    std::fprintf(stderr, "\n");
+  }
+
+}
+
+#ifdef KKD_TRACK_ALLOCATIONS
+
+void *operator new(std::size_t size) {
+  kkd::recordAllocation(size);
+
+  if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  kkd::recordAllocation(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_ALLOCATION_TRACKER_H
+#define KKD_ALLOCATION_TRACKER_H
+
+#include <cstddef>
+
+namespace kkd {
+
+  // the parts of a frame the heap allocations are charged to
+  enum class Subsystem : std::size_t {
+    Other,
+    Input,
+    Kreatures,
+    Map,
+    Hud,
+    Render,
+  };
+
+  constexpr std::size_t SubsystemCount = static_cast<std::size_t>(Subsystem::Render) + 1;
+
+  const char *getSubsystemName(Subsystem subsystem);
+
+  struct AllocationStats {
+    std::size_t count;
+    std::size_t bytes;
+  };
+
+  // Counts the heap allocations by subsystem. The global operator new is
+  // only replaced when the game is built with KROKODILE_TRACK_ALLOCATIONS,
+  // otherwise nothing is counted.
+  class AllocationTracker {
+  public:
+    static constexpr bool isEnabled() {
+#ifdef KKD_TRACK_ALLOCATIONS
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    // the allocations since the last call, the counters are reset
+    static AllocationStats takeStats(Subsystem subsystem);
+
+    // the allocations of the thread go to subsystem while the scope lives
+    class Scope {
+    public:
+      explicit Scope(Subsystem subsystem);
+      ~Scope();
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+    private:
+      Subsystem m_previous;
+    };
+  };
+
+  // Prints the allocations of every frame that allocated, and a summary
+  // at the end. It does nothing when the allocations are not tracked.
+  class AllocationReport {
+  public:
+    AllocationReport();
+    ~AllocationReport();
+
+    AllocationReport(const AllocationReport&) = delete;
+    AllocationReport& operator=(const AllocationReport&) = delete;
+
+    void endFrame();
+
+  private:
+    unsigned long m_frame;
+    unsigned long m_allocatingFrames;
+  };
+
+}
+
+#endif // KKD_ALLOCATION_TRACKER_H
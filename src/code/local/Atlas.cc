@@ -0,0 +1,52 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Atlas.h"
+
+#include <cassert>
+
+#include "Singletons.h"
+
+namespace kkd {
+
+  namespace {
+    const AtlasRegionData& getRegionData(AtlasRegion region) {
+      std::size_t index = static_cast<std::size_t>(region);
+      assert(index < AtlasRegionCount);
+      return AtlasRegions[index];
+    }
+  }
+
+  gf::Texture& getAtlasTexture() {
+    return gResourceManager().getTexture(AtlasTextureName);
+  }
+
+  gf::Path getAtlasPath() {
+    return gResourceManager().getAbsolutePath(AtlasTextureName);
+  }
+
+  gf::RectF getAtlasRect(AtlasRegion region) {
+    const AtlasRegionData& data = getRegionData(region);
+    return gf::RectF({ data.left, data.top }, { data.width, data.height });
+  }
+
+  gf::Vector2f getAtlasSize(AtlasRegion region) {
+    const AtlasRegionData& data = getRegionData(region);
+    return { static_cast<float>(data.pixelWidth), static_cast<float>(data.pixelHeight) };
+  }
+
+}
@@ -0,0 +1,45 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KKD_ATLAS_H
+#define KKD_ATLAS_H
+
+#include <gf/Path.h>
+#include <gf/Rect.h>
+#include <gf/Texture.h>
+#include <gf/Vector.h>
+
+#include "atlas_regions.h"
+
+namespace kkd {
+
+  // the atlas packed at build time, see krokodile-atlas
+  // it is not smoothed, like the kreature textures it replaces
+  gf::Texture& getAtlasTexture();
+
+  // the image of the atlas, to load a texture with another filtering
+  gf::Path getAtlasPath();
+
+  // normalized texture rectangle of a region
+  gf::RectF getAtlasRect(AtlasRegion region);
+
+  // size of a region in pixels
+  gf::Vector2f getAtlasSize(AtlasRegion region);
+
+}
+
+#endif // KKD_ATLAS_H
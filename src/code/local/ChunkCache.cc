@@ -0,0 +1,387 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ChunkCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define KKD_CHUNK_CACHE_MMAP
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <direct.h>
+#include <io.h>
+#include <sys/utime.h>
+#endif
+
+namespace kkd {
+
+  static constexpr std::size_t MaxOpenRegions = 32;
+  static constexpr char Magic[4] = { 'K', 'K', 'D', 'M' };
+
+  namespace {
+
+    int floorDiv(int value, int divisor) {
+      return value >= 0 ? value / divisor : - ((- value - 1) / divisor) - 1;
+    }
+
+    bool makeDirectory(const std::string& path) {
+#if defined(KKD_CHUNK_CACHE_MMAP)
+      return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#elif defined(_WIN32)
+      return ::_mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+      (void) path;
+      return false;
+#endif
+    }
+
+    struct CacheFile {
+      std::string name;
+      int64_t lastUse;
+      uint64_t size;
+    };
+
+    std::vector<CacheFile> listCacheFiles(const std::string& directory) {
+      std::vector<CacheFile> files;
+
+#if defined(KKD_CHUNK_CACHE_MMAP)
+      DIR *dir = ::opendir(directory.c_str());
+
+      if (dir == nullptr) {
+        return files;
+      }
+
+      while (struct dirent *entry = ::readdir(dir)) {
+        struct stat info;
+
+        if (std::strncmp(entry->d_name, "map-", 4) != 0 || ::stat((directory + '/' + entry->d_name).c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+          continue;
+        }
+
+        files.push_back({ entry->d_name, static_cast<int64_t>(info.st_mtime), static_cast<uint64_t>(info.st_size) });
+      }
+
+      ::closedir(dir);
+#elif defined(_WIN32)
+      struct _finddata_t info;
+      intptr_t search = ::_findfirst((directory + "/map-*.bin").c_str(), &info);
+
+      if (search == -1) {
+        return files;
+      }
+
+      do {
+        files.push_back({ info.name, static_cast<int64_t>(info.time_write), static_cast<uint64_t>(info.size) });
+      } while (::_findnext(search, &info) == 0);
+
+      ::_findclose(search);
+#else
+      (void) directory;
+#endif
+
+      return files;
+    }
+
+  }
+
+  constexpr int ChunkCache::RegionSize;
+  constexpr int ChunkCache::TileBits;
+  constexpr uint64_t ChunkCache::MaxDirectoryBytes;
+
+  ChunkCache::ChunkCache(std::string directory, uint32_t seed, int chunkSize, uint32_t version)
+  : m_directory(std::move(directory))
+  , m_seed(seed)
+  , m_chunkSize(chunkSize)
+  , m_version(version)
+  {
+    assert((chunkSize * chunkSize * TileBits) % 8 == 0);
+
+    if (!m_directory.empty() && !makeDirectory(m_directory)) {
+      m_directory.clear();
+    }
+
+    if (!m_directory.empty()) {
+      pruneDirectory();
+    }
+  }
+
+  ChunkCache::~ChunkCache() {
+    for (auto& region : m_regions) {
+      closeRegion(region);
+    }
+  }
+
+  bool ChunkCache::isEnabled() const {
+    return !m_directory.empty();
+  }
+
+  bool ChunkCache::load(gf::Vector2i chunk, uint8_t *tiles) {
+    if (!isEnabled()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Region *region = openRegion({ floorDiv(chunk.x, RegionSize), floorDiv(chunk.y, RegionSize) });
+
+    if (region == nullptr) {
+      return false;
+    }
+
+    gf::Vector2i local = chunk - region->coords * RegionSize;
+    std::size_t presence = sizeof(Header) + local.y * RegionSize + local.x;
+
+    if (region->data[presence] == 0) {
+      return false;
+    }
+
+    const uint8_t *packed = region->data + getChunkOffset(local);
+    const int tilesPerByte = 8 / TileBits;
+    const uint8_t mask = (1 << TileBits) - 1;
+
+    for (int i = 0; i < m_chunkSize * m_chunkSize; ++i) {
+      tiles[i] = (packed[i / tilesPerByte] >> ((i % tilesPerByte) * TileBits)) & mask;
+    }
+
+    return true;
+  }
+
+  void ChunkCache::store(gf::Vector2i chunk, const uint8_t *tiles) {
+    if (!isEnabled()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Region *region = openRegion({ floorDiv(chunk.x, RegionSize), floorDiv(chunk.y, RegionSize) });
+
+    if (region == nullptr) {
+      return;
+    }
+
+    gf::Vector2i local = chunk - region->coords * RegionSize;
+    std::size_t presence = sizeof(Header) + local.y * RegionSize + local.x;
+    std::size_t offset = getChunkOffset(local);
+
+    uint8_t *packed = region->data + offset;
+    const int tilesPerByte = 8 / TileBits;
+    std::memset(packed, 0, getChunkBytes());
+
+    for (int i = 0; i < m_chunkSize * m_chunkSize; ++i) {
+      assert(tiles[i] < (1 << TileBits));
+      packed[i / tilesPerByte] |= tiles[i] << ((i % tilesPerByte) * TileBits);
+    }
+
+    // the tiles before the flag, a chunk is never seen half written
+    region->data[presence] = 1;
+
+#if !defined(KKD_CHUNK_CACHE_MMAP)
+    std::fstream file(getFilename(region->coords), std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(packed), getChunkBytes());
+    file.seekp(presence);
+    file.put(1);
+#endif
+  }
+
+  std::string ChunkCache::getDefaultDirectory() {
+    std::string base;
+
+    if (const char *cache = std::getenv("XDG_CACHE_HOME")) {
+      base = cache;
+    } else if (const char *home = std::getenv("HOME")) {
+      base = std::string(home) + "/.cache";
+      makeDirectory(base);
+    } else if (const char *local = std::getenv("LOCALAPPDATA")) {
+      base = local;
+    }
+
+    if (base.empty()) {
+      return std::string();
+    }
+
+    return base + "/krokodile";
+  }
+
+  std::size_t ChunkCache::getChunkBytes() const {
+    return static_cast<std::size_t>(m_chunkSize) * m_chunkSize * TileBits / 8;
+  }
+
+  std::size_t ChunkCache::getFileSize() const {
+    return sizeof(Header) + RegionSize * RegionSize * (1 + getChunkBytes());
+  }
+
+  std::size_t ChunkCache::getChunkOffset(gf::Vector2i chunk) const {
+    return sizeof(Header) + RegionSize * RegionSize + (chunk.y * RegionSize + chunk.x) * getChunkBytes();
+  }
+
+  ChunkCache::Header ChunkCache::createHeader(gf::Vector2i region) const {
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, Magic, sizeof Magic);
+    header.version = m_version;
+    header.seed = m_seed;
+    header.chunkSize = m_chunkSize;
+    header.regionX = region.x;
+    header.regionY = region.y;
+    return header;
+  }
+
+  std::string ChunkCache::getFilename(gf::Vector2i region) const {
+    char name[96];
+    std::snprintf(name, sizeof name, "/map-%08x-%d-v%u-r%d_%d.bin", static_cast<unsigned>(m_seed), m_chunkSize, static_cast<unsigned>(m_version), region.x, region.y);
+    return m_directory + name;
+  }
+
+  void ChunkCache::pruneDirectory() {
+    std::vector<CacheFile> files = listCacheFiles(m_directory);
+
+    // most recently used first
+    std::sort(files.begin(), files.end(), [](const CacheFile& lhs, const CacheFile& rhs) {
+      return lhs.lastUse > rhs.lastUse;
+    });
+
+    uint64_t total = 0;
+
+    for (auto& file : files) {
+      unsigned seed, version;
+      int chunkSize;
+
+      // the regions of another version or chunk size are never read again
+      bool stale = std::sscanf(file.name.c_str(), "map-%x-%d-v%u-", &seed, &chunkSize, &version) != 3
+          || version != m_version || chunkSize != m_chunkSize;
+
+      if (!stale && total + file.size <= MaxDirectoryBytes) {
+        total += file.size;
+        continue;
+      }
+
+      std::remove((m_directory + '/' + file.name).c_str());
+    }
+  }
+
+  ChunkCache::Region *ChunkCache::openRegion(gf::Vector2i coords) {
+    for (auto it = m_regions.begin(); it != m_regions.end(); ++it) {
+      if (it->coords == coords) {
+        m_regions.splice(m_regions.begin(), m_regions, it);
+        return &m_regions.front();
+      }
+    }
+
+    if (m_regions.size() >= MaxOpenRegions) {
+      closeRegion(m_regions.back());
+      m_regions.pop_back();
+    }
+
+    Region region;
+    region.coords = coords;
+    region.data = nullptr;
+
+    if (!mapRegion(region, getFilename(coords))) {
+      return nullptr;
+    }
+
+    // a file from another version or another seed starts again empty
+    Header header = createHeader(coords);
+
+    if (std::memcmp(region.data, &header, sizeof(Header)) != 0) {
+      std::memset(region.data, 0, getFileSize());
+      std::memcpy(region.data, &header, sizeof(Header));
+
+#if !defined(KKD_CHUNK_CACHE_MMAP)
+      std::ofstream file(getFilename(coords), std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char *>(region.data), getFileSize());
+#endif
+    }
+
+    m_regions.push_front(std::move(region));
+    return &m_regions.front();
+  }
+
+#if defined(KKD_CHUNK_CACHE_MMAP)
+
+  bool ChunkCache::mapRegion(Region& region, const std::string& filename) {
+    int file = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+
+    if (file == -1) {
+      return false;
+    }
+
+    // the modification time is the last use, see pruneDirectory()
+    ::futimens(file, nullptr);
+
+    struct stat info;
+    std::size_t size = getFileSize();
+
+    if (::fstat(file, &info) != 0 || (static_cast<std::size_t>(info.st_size) != size && ::ftruncate(file, size) != 0)) {
+      ::close(file);
+      return false;
+    }
+
+    void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    ::close(file); // the mapping keeps the file
+
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    region.data = static_cast<uint8_t *>(data);
+    return true;
+  }
+
+  void ChunkCache::closeRegion(Region& region) {
+    ::munmap(region.data, getFileSize());
+    region.data = nullptr;
+  }
+
+#else
+
+  bool ChunkCache::mapRegion(Region& region, const std::string& filename) {
+    region.buffer.assign(getFileSize(), 0);
+
+#if defined(_WIN32)
+    // the modification time is the last use, see pruneDirectory()
+    ::_utime(filename.c_str(), nullptr);
+#endif
+
+    std::ifstream file(filename, std::ios::binary);
+
+    if (file) {
+      file.read(reinterpret_cast<char *>(region.buffer.data()), region.buffer.size());
+    }
+
+    region.data = region.buffer.data();
+    return true;
+  }
+
+  void ChunkCache::closeRegion(Region& region) {
+    region.data = nullptr;
+    region.buffer.clear();
+  }
+
+#endif
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_CHUNK_CACHE_H
+#define KKD_CHUNK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gf/Vector.h>
+
+namespace kkd {
+
+  // Generated tiles on disk, so that a world with the same seed is not
+  // generated twice. Chunks are grouped in region files of RegionSize *
+  // RegionSize chunks, with two bits per tile, and the files are memory
+  // mapped where the platform allows it. The name and the header of a file
+  // hold the seed, the chunk size and the generator version, a file that
+  // does not match is rebuilt.
+  //
+  // The game takes a new seed on every run, so the directory is bounded when
+  // the cache is opened: the files of another generator version or chunk size
+  // are deleted, then the least recently used files beyond MaxDirectoryBytes.
+  // Opening a region counts as a use.
+  class ChunkCache {
+  public:
+    static constexpr int RegionSize = 16; // in chunks
+    static constexpr int TileBits = 2;
+    static constexpr uint64_t MaxDirectoryBytes = 32 * 1024 * 1024;
+
+    // an empty directory disables the cache
+    ChunkCache(std::string directory, uint32_t seed, int chunkSize, uint32_t version);
+    ~ChunkCache();
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    bool isEnabled() const;
+
+    // both can be called from several threads at once
+    bool load(gf::Vector2i chunk, uint8_t *tiles);
+    void store(gf::Vector2i chunk, const uint8_t *tiles);
+
+    // $XDG_CACHE_HOME/krokodile, ~/.cache/krokodile, or empty
+    static std::string getDefaultDirectory();
+
+  private:
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      uint32_t seed;
+      uint32_t chunkSize;
+      int32_t regionX;
+      int32_t regionY;
+      uint32_t reserved[2];
+    };
+
+    struct Region {
+      gf::Vector2i coords;
+      uint8_t *data; // the whole file, mapped or in buffer
+      std::vector<uint8_t> buffer; // without memory mapping
+    };
+
+    std::size_t getChunkBytes() const;
+    std::size_t getFileSize() const;
+    std::size_t getChunkOffset(gf::Vector2i chunk) const;
+    Header createHeader(gf::Vector2i region) const;
+    std::string getFilename(gf::Vector2i region) const;
+
+    void pruneDirectory();
+
+    Region *openRegion(gf::Vector2i coords);
+    bool mapRegion(Region& region, const std::string& filename);
+    void closeRegion(Region& region);
+
+  private:
+    std::string m_directory;
+    uint32_t m_seed;
+    int m_chunkSize;
+    uint32_t m_version;
+
+    std::mutex m_mutex;
+    std::list<Region> m_regions; // most recently used first
+  };
+
+}
+
+#endif // KKD_CHUNK_CACHE_H
@@ -0,0 +1,68 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "EventQueue.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace kkd {
+
+  namespace {
+
+    // the earliest event on top, ties are broken so that the order does not
+    // depend on the insertion order
+    bool isLater(const EventQueue::Event& lhs, const EventQueue::Event& rhs) {
+      if (lhs.time != rhs.time) {
+        return lhs.time > rhs.time;
+      }
+
+      if (lhs.id != rhs.id) {
+        return lhs.id > rhs.id;
+      }
+
+      return lhs.type > rhs.type;
+    }
+
+  }
+
+  void EventQueue::clear() {
+    m_heap.clear();
+  }
+
+  void EventQueue::push(gf::Time time, Type type, uint64_t id) {
+    m_heap.push_back({ time, type, id });
+    std::push_heap(m_heap.begin(), m_heap.end(), isLater);
+  }
+
+  bool EventQueue::hasEventBefore(gf::Time time) const {
+    return !m_heap.empty() && m_heap.front().time <= time;
+  }
+
+  EventQueue::Event EventQueue::pop() {
+    assert(!m_heap.empty());
+    std::pop_heap(m_heap.begin(), m_heap.end(), isLater);
+    Event event = m_heap.back();
+    m_heap.pop_back();
+    return event;
+  }
+
+  std::size_t EventQueue::getSize() const {
+    return m_heap.size();
+  }
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_EVENT_QUEUE_H
+#define KKD_EVENT_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gf/Time.h>
+
+namespace kkd {
+
+  // Events ordered by their date in the simulation time. An event is not
+  // cancelled, the receiver checks that it is still relevant when it fires.
+  class EventQueue {
+  public:
+    enum class Type {
+      LifeExpired,
+      WaypointReached,
+    };
+
+    struct Event {
+      gf::Time time;
+      Type type;
+      uint64_t id;
+    };
+
+    void clear();
+
+    void push(gf::Time time, Type type, uint64_t id);
+
+    // true if the earliest event happens before or at time
+    bool hasEventBefore(gf::Time time) const;
+    Event pop();
+
+    std::size_t getSize() const;
+
+  private:
+    std::vector<Event> m_heap;
+  };
+
+}
+
+#endif // KKD_EVENT_QUEUE_H
@@ -0,0 +1,52 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FixedTimestep.h"
+
+namespace kkd {
+
+  FixedTimestep::FixedTimestep(gf::Time step, int maxSteps)
+  : m_step(step)
+  , m_maxSteps(maxSteps)
+  {
+  }
+
+  int FixedTimestep::advance(gf::Time time) {
+    m_accumulator += time;
+
+    int steps = 0;
+    while (m_accumulator >= m_step && steps < m_maxSteps) {
+      m_accumulator -= m_step;
+      ++steps;
+    }
+
+    if (m_accumulator >= m_step) {
+      m_accumulator = gf::Time();
+    }
+
+    return steps;
+  }
+
+  gf::Time FixedTimestep::getStep() const {
+    return m_step;
+  }
+
+  float FixedTimestep::getInterpolation() const {
+    return m_accumulator.asSeconds() / m_step.asSeconds();
+  }
+
+}
@@ -0,0 +1,54 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_FIXED_TIMESTEP_H
+#define KKD_FIXED_TIMESTEP_H
+
+#include <gf/Time.h>
+
+namespace kkd {
+
+  // the simulation rate of the game, and of its replays
+  constexpr gf::Time SimulationStep = gf::seconds(1.0f / 60.0f);
+  constexpr int MaxSimulationSteps = 5;
+
+  // Cuts the time of the frames in simulation steps of a fixed duration.
+  // The rest is carried to the next frame, and the rendering interpolates
+  // with it. After a hitch, the time that can not be caught up in
+  // maxSteps steps is dropped.
+  class FixedTimestep {
+  public:
+    FixedTimestep(gf::Time step, int maxSteps);
+
+    // the number of steps to run for a frame of this duration
+    int advance(gf::Time time);
+
+    gf::Time getStep() const;
+
+    // position between the last two steps, from 0 to 1
+    float getInterpolation() const;
+
+  private:
+    gf::Time m_step;
+    int m_maxSteps;
+    gf::Time m_accumulator;
+  };
+
+}
+
+#endif // KKD_FIXED_TIMESTEP_H
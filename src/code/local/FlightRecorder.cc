@@ -0,0 +1,140 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FlightRecorder.h"
+
+#include <cstdio>
+
+#include "FrameProfiler.h"
+#include "KreatureContainer.h"
+#include "Singletons.h"
+
+namespace kkd {
+
+  constexpr std::size_t FlightRecorder::Capacity;
+  constexpr unsigned long FlightRecorder::WarmupFrames;
+  constexpr unsigned long FlightRecorder::Cooldown;
+  constexpr std::size_t FlightRecorder::MaxDumps;
+
+  namespace {
+    std::size_t getDeliveredMessageCount() {
+      std::size_t count = 0;
+
+      for (std::size_t i = 0; i < gMessageBus().getMessageTypeCount(); ++i) {
+        count += gMessageBus().getStats(i).count;
+      }
+
+      return count;
+    }
+  }
+
+  FlightRecorder::FlightRecorder(const KreatureContainer& kreatures, float threshold)
+  : m_kreatures(kreatures)
+  , m_threshold(threshold)
+  , m_records(Capacity)
+  , m_next(0)
+  , m_count(0)
+  , m_frame(0)
+  , m_lastDump(0)
+  , m_dumps(0)
+  , m_previousSpawns(kreatures.getSpawnCount())
+  , m_previousDespawns(kreatures.getDespawnCount())
+  , m_previousMessages(getDeliveredMessageCount())
+  {
+  }
+
+  void FlightRecorder::endFrame() {
+    ++m_frame;
+
+    uint64_t spawns = m_kreatures.getSpawnCount();
+    uint64_t despawns = m_kreatures.getDespawnCount();
+    std::size_t messages = getDeliveredMessageCount();
+
+    // written in place, nothing is allocated
+    FlightRecord& record = m_records[m_next];
+    record.frame = m_frame;
+    record.frameTime = FrameProfiler::getFrameTimeCount() > 0 ? FrameProfiler::getFrameTime(FrameProfiler::getFrameTimeCount() - 1) : 0.0f;
+    record.population = m_kreatures.getPopulation();
+    record.spawned = static_cast<std::size_t>(spawns - m_previousSpawns);
+    record.despawned = static_cast<std::size_t>(despawns - m_previousDespawns);
+    record.spawnQueue = m_kreatures.getSpawnQueueDepth();
+    record.messages = messages - m_previousMessages;
+
+    m_previousSpawns = spawns;
+    m_previousDespawns = despawns;
+    m_previousMessages = messages;
+
+    m_next = (m_next + 1) % Capacity;
+
+    if (m_count < Capacity) {
+      ++m_count;
+    }
+
+    if (m_threshold <= 0.0f || record.frameTime <= m_threshold) {
+      return;
+    }
+
+    if (m_frame <= WarmupFrames || m_dumps >= MaxDumps || (m_dumps > 0 && m_frame - m_lastDump < Cooldown)) {
+      return;
+    }
+
+    dump(record);
+  }
+
+  std::size_t FlightRecorder::getDumpCount() const {
+    return m_dumps;
+  }
+
+  void FlightRecorder::dump(const FlightRecord& hitch) {
+    m_lastDump = m_frame;
+    ++m_dumps;
+
+    char filename[64];
+    std::snprintf(filename, sizeof(filename), "krokodile-hitch-%lu.txt", hitch.frame);
+
+    std::FILE *file = std::fopen(filename, "w");
+
+    if (file == nullptr) {
+      std::fprintf(stderr, "Could not write the hitch of frame %lu to %s\n", hitch.frame, filename);
+      return;
+    }
+
+    std::fprintf(file, "# hitch: frame %lu, %.2f ms, threshold %.2f ms\n", hitch.frame, hitch.frameTime, m_threshold);
+
+    std::fprintf(file, "\n# zones\n");
+
+    for (std::size_t i = 0; i < FrameProfiler::getZoneStatsCount(); ++i) {
+      ZoneStats stats = FrameProfiler::getZoneStats(i);
+      std::fprintf(file, "%s %.3f ms (%zu)\n", stats.name, stats.milliseconds, stats.calls);
+    }
+
+    std::fprintf(file, "\n# frames, oldest first\n");
+    std::fprintf(file, "frame time_ms population spawned despawned spawn_queue messages\n");
+
+    for (std::size_t i = 0; i < m_count; ++i) {
+      const FlightRecord& record = m_records[(m_next + Capacity - m_count + i) % Capacity];
+      std::fprintf(file, "%lu %.3f %zu %zu %zu %zu %zu\n", record.frame, record.frameTime, record.population, record.spawned, record.despawned, record.spawnQueue, record.messages);
+    }
+
+    std::fprintf(file, "\n# kreatures\n");
+    m_kreatures.writeSnapshot(file);
+
+    std::fclose(file);
+    std::fprintf(stderr, "Hitch of %.2f ms at frame %lu written to %s\n", hitch.frameTime, hitch.frame, filename);
+  }
+
+}
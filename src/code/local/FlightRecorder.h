@@ -0,0 +1,78 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_FLIGHT_RECORDER_H
+#define KKD_FLIGHT_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kkd {
+  class KreatureContainer;
+
+  struct FlightRecord {
+    unsigned long frame;
+    float frameTime; // in milliseconds
+    std::size_t population;
+    std::size_t spawned; // during the frame
+    std::size_t despawned;
+    std::size_t spawnQueue;
+    std::size_t messages; // delivered during the frame
+  };
+
+  // Keeps the last frames in a ring buffer that is allocated once. When a
+  // frame is longer than the threshold, the frames, the profiler zones of
+  // the frame and a snapshot of the kreatures are written to
+  // krokodile-hitch-FRAME.txt in the working directory.
+  class FlightRecorder {
+  public:
+    static constexpr std::size_t Capacity = 300; // frames
+    static constexpr unsigned long WarmupFrames = 30; // the loading is not a hitch
+    static constexpr unsigned long Cooldown = 60; // frames between two dumps
+    static constexpr std::size_t MaxDumps = 10;
+
+    // a threshold of 0 disables the dumps
+    FlightRecorder(const KreatureContainer& kreatures, float threshold);
+
+    // after FrameProfiler::endFrame(), from which the frame time comes
+    void endFrame();
+
+    std::size_t getDumpCount() const;
+
+  private:
+    void dump(const FlightRecord& hitch);
+
+  private:
+    const KreatureContainer& m_kreatures;
+    float m_threshold;
+
+    std::vector<FlightRecord> m_records;
+    std::size_t m_next;
+    std::size_t m_count;
+
+    unsigned long m_frame;
+    unsigned long m_lastDump;
+    std::size_t m_dumps;
+    uint64_t m_previousSpawns;
+    uint64_t m_previousDespawns;
+    std::size_t m_previousMessages;
+  };
+}
+
+#endif // KKD_FLIGHT_RECORDER_H
@@ -0,0 +1,81 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace kkd {
+
+  constexpr std::size_t FrameArena::DefaultCapacity;
+
+  FrameArena::FrameArena(std::size_t capacity)
+  : m_offset(0)
+  , m_used(0)
+  {
+    m_blocks.reserve(8);
+    m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[capacity]), capacity });
+  }
+
+  void *FrameArena::allocate(std::size_t size, std::size_t alignment) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    Block& block = m_blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    std::size_t offset = ((base + m_offset + alignment - 1) & ~(alignment - 1)) - base;
+
+    if (offset + size > block.size) {
+      // large enough for the request whatever its alignment
+      std::size_t extra = std::max(size + alignment, block.size);
+      m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[extra]), extra });
+      m_offset = 0;
+      return allocate(size, alignment);
+    }
+
+    m_used += offset - m_offset + size;
+    m_offset = offset + size;
+    return block.data.get() + offset;
+  }
+
+  void FrameArena::reset() {
+    if (m_blocks.size() > 1) {
+      // one block as large as all the blocks of the frame
+      std::size_t capacity = 0;
+
+      for (auto& block : m_blocks) {
+        capacity += block.size;
+      }
+
+      m_blocks.clear();
+      m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[capacity]), capacity });
+    }
+
+    m_offset = 0;
+    m_used = 0;
+  }
+
+  std::size_t FrameArena::getCapacity() const {
+    return m_blocks.front().size;
+  }
+
+  std::size_t FrameArena::getUsedSize() const {
+    return m_used;
+  }
+
+}
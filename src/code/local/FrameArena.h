@@ -0,0 +1,110 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_FRAME_ARENA_H
+#define KKD_FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace kkd {
+
+  // Linear allocator for the data that only lives during a frame. The
+  // memory is given back all at once by reset(), at the start of the
+  // frame. When a frame needs more than the capacity, the extra memory
+  // comes from the heap and the capacity grows at the next reset, so
+  // that a steady frame does not allocate.
+  class FrameArena {
+  public:
+    explicit FrameArena(std::size_t capacity = DefaultCapacity);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void *allocate(std::size_t size, std::size_t alignment);
+
+    void reset();
+
+    std::size_t getCapacity() const;
+    std::size_t getUsedSize() const; // since the last reset
+
+  private:
+    static constexpr std::size_t DefaultCapacity = 256 * 1024;
+
+    struct Block {
+      std::unique_ptr<unsigned char[]> data;
+      std::size_t size;
+    };
+
+    std::vector<Block> m_blocks; // the first one is the main block
+    std::size_t m_offset; // in the last block
+    std::size_t m_used; // in all the blocks
+  };
+
+  // allocator for the standard containers, the memory is never freed
+  // before the reset of the arena
+  template<typename T>
+  class FrameAllocator {
+  public:
+    using value_type = T;
+
+    explicit FrameAllocator(FrameArena& arena)
+    : m_arena(&arena)
+    {
+    }
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other)
+    : m_arena(other.getArena())
+    {
+    }
+
+    T *allocate(std::size_t count) {
+      return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t count) {
+      (void) ptr;
+      (void) count;
+    }
+
+    FrameArena *getArena() const {
+      return m_arena;
+    }
+
+  private:
+    FrameArena *m_arena;
+  };
+
+  template<typename T, typename U>
+  bool operator==(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) {
+    return lhs.getArena() == rhs.getArena();
+  }
+
+  template<typename T, typename U>
+  bool operator!=(const FrameAllocator<T>& lhs, const FrameAllocator<U>& rhs) {
+    return lhs.getArena() != rhs.getArena();
+  }
+
+  template<typename T>
+  using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}
+
+#endif // KKD_FRAME_ARENA_H
@@ -0,0 +1,204 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace kkd {
+
+  constexpr std::size_t FrameProfiler::MaxZonesPerFrame;
+  constexpr std::size_t FrameProfiler::MaxZoneNames;
+  constexpr std::size_t FrameProfiler::HistorySize;
+
+  namespace {
+    struct ZoneRecord {
+      const char *name;
+      uint64_t start; // in nanoseconds since the origin
+      uint64_t end;
+      unsigned thread;
+    };
+
+    const std::chrono::steady_clock::time_point gOrigin = std::chrono::steady_clock::now();
+
+    uint64_t getNow() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gOrigin).count();
+    }
+
+    std::atomic<unsigned> gThreadCount(0);
+
+    unsigned getThreadIndex() {
+      thread_local unsigned index = gThreadCount.fetch_add(1, std::memory_order_relaxed);
+      return index;
+    }
+
+    // the zones of the current frame, filled by any thread
+    ZoneRecord gZones[FrameProfiler::MaxZonesPerFrame];
+    std::atomic<std::size_t> gZoneCount(0);
+
+    uint64_t gFrameStart = 0;
+    unsigned gFrameThread = 0;
+    unsigned long gFrame = 0;
+
+    float gFrameTimes[FrameProfiler::HistorySize];
+    std::size_t gFrameTimeCount = 0;
+    std::size_t gFrameTimeNext = 0;
+
+    ZoneStats gZoneStats[FrameProfiler::MaxZoneNames];
+    std::size_t gZoneStatsCount = 0;
+    std::size_t gDroppedZones = 0;
+
+    std::FILE *gCapture = nullptr;
+    bool gCaptureHasEvents = false;
+
+    void writeEvent(const char *name, uint64_t start, uint64_t end, unsigned thread) {
+      // the timestamps are in microseconds
+      std::fprintf(gCapture, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+        gCaptureHasEvents ? "," : "", name, start / 1e3, (end - start) / 1e3, thread);
+      gCaptureHasEvents = true;
+    }
+
+    void addZoneStats(const ZoneRecord& zone) {
+      for (std::size_t i = 0; i < gZoneStatsCount; ++i) {
+        ZoneStats& stats = gZoneStats[i];
+
+        if (stats.name == zone.name || std::strcmp(stats.name, zone.name) == 0) {
+          ++stats.calls;
+          stats.milliseconds += (zone.end - zone.start) / 1e6;
+          return;
+        }
+      }
+
+      if (gZoneStatsCount == FrameProfiler::MaxZoneNames) {
+        return;
+      }
+
+      ZoneStats& stats = gZoneStats[gZoneStatsCount++];
+      stats.name = zone.name;
+      stats.calls = 1;
+      stats.milliseconds = (zone.end - zone.start) / 1e6;
+    }
+  }
+
+  void FrameProfiler::beginFrame() {
+    gFrameStart = getNow();
+    gFrameThread = getThreadIndex();
+  }
+
+  void FrameProfiler::endFrame() {
+    uint64_t frameEnd = getNow();
+    ++gFrame;
+
+    gFrameTimes[gFrameTimeNext] = static_cast<float>((frameEnd - gFrameStart) / 1e6);
+    gFrameTimeNext = (gFrameTimeNext + 1) % HistorySize;
+
+    if (gFrameTimeCount < HistorySize) {
+      ++gFrameTimeCount;
+    }
+
+    // the zones are all closed, the other threads do not write anymore
+    std::size_t count = gZoneCount.exchange(0, std::memory_order_acquire);
+    gDroppedZones = count > MaxZonesPerFrame ? count - MaxZonesPerFrame : 0;
+    count = std::min(count, MaxZonesPerFrame);
+
+    gZoneStatsCount = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      addZoneStats(gZones[i]);
+    }
+
+    if (gCapture != nullptr) {
+      writeEvent("frame", gFrameStart, frameEnd, gFrameThread);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        writeEvent(gZones[i].name, gZones[i].start, gZones[i].end, gZones[i].thread);
+      }
+    }
+  }
+
+  std::size_t FrameProfiler::getFrameTimeCount() {
+    return gFrameTimeCount;
+  }
+
+  float FrameProfiler::getFrameTime(std::size_t index) {
+    return gFrameTimes[(gFrameTimeNext + HistorySize - gFrameTimeCount + index) % HistorySize];
+  }
+
+  std::size_t FrameProfiler::getZoneStatsCount() {
+    return gZoneStatsCount;
+  }
+
+  ZoneStats FrameProfiler::getZoneStats(std::size_t index) {
+    return gZoneStats[index];
+  }
+
+  std::size_t FrameProfiler::getDroppedZoneCount() {
+    return gDroppedZones;
+  }
+
+  bool FrameProfiler::startCapture(const std::string& filename) {
+    stopCapture();
+
+    gCapture = std::fopen(filename.c_str(), "w");
+
+    if (gCapture == nullptr) {
+      return false;
+    }
+
+    std::fprintf(gCapture, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    gCaptureHasEvents = false;
+    return true;
+  }
+
+  void FrameProfiler::stopCapture() {
+    if (gCapture == nullptr) {
+      return;
+    }
+
+    std::fprintf(gCapture, "\n]}\n");
+    std::fclose(gCapture);
+    gCapture = nullptr;
+  }
+
+  bool FrameProfiler::isCapturing() {
+    return gCapture != nullptr;
+  }
+
+  FrameProfiler::Zone::Zone(const char *name)
+  : m_name(name)
+  , m_start(getNow())
+  {
+  }
+
+  FrameProfiler::Zone::~Zone() {
+    uint64_t end = getNow();
+    std::size_t index = gZoneCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (index < MaxZonesPerFrame) {
+      ZoneRecord& zone = gZones[index];
+      zone.name = m_name;
+      zone.start = m_start;
+      zone.end = end;
+      zone.thread = getThreadIndex();
+    }
+  }
+
+}
@@ -0,0 +1,81 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_FRAME_PROFILER_H
+#define KKD_FRAME_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kkd {
+
+  struct ZoneStats {
+    const char *name;
+    std::size_t calls;
+    double milliseconds; // summed over the calls, and over the threads
+  };
+
+  // Measures the frames and the zones inside them on a monotonic clock.
+  // The zones are stored in fixed buffers, so that the profiler does not
+  // allocate and can stay in release builds. A zone name must be a string
+  // literal, and a zone must be closed before the end of its frame: the
+  // threads of the worker pool can open zones, not the map generators.
+  class FrameProfiler {
+  public:
+    static constexpr std::size_t MaxZonesPerFrame = 4096;
+    static constexpr std::size_t MaxZoneNames = 32;
+    static constexpr std::size_t HistorySize = 240; // frames
+
+    static void beginFrame();
+    static void endFrame();
+
+    // the durations of the last frames in milliseconds, the oldest first
+    static std::size_t getFrameTimeCount();
+    static float getFrameTime(std::size_t index);
+
+    // the zones of the last frame, grouped by name, in order of appearance
+    static std::size_t getZoneStatsCount();
+    static ZoneStats getZoneStats(std::size_t index);
+
+    // zones that did not fit in the last frame
+    static std::size_t getDroppedZoneCount();
+
+    // writes the next frames in the Chrome trace event format, to be
+    // opened in chrome://tracing or ui.perfetto.dev
+    static bool startCapture(const std::string& filename);
+    static void stopCapture();
+    static bool isCapturing();
+
+    class Zone {
+    public:
+      explicit Zone(const char *name);
+      ~Zone();
+
+      Zone(const Zone&) = delete;
+      Zone& operator=(const Zone&) = delete;
+
+    private:
+      const char *m_name;
+      uint64_t m_start;
+    };
+  };
+
+}
+
+#endif // KKD_FRAME_PROFILER_H
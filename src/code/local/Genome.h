@@ -0,0 +1,109 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_GENOME_H
+#define KKD_GENOME_H
+
+#include <cstdint>
+
+namespace kkd {
+
+  enum ColorName : int {
+    Azure = 0,
+    Green = 1,
+    Yellow = 2,
+    Red = 3,
+    Magenta = 4,
+  };
+
+  constexpr int ColorCount = 5;
+  constexpr int AnimalCount = 3; // krokodile, elephant, lion
+
+  enum class GenomePart : int {
+    Head = 0,
+    Body = 1,
+    Limbs = 2,
+    Tail = 3,
+  };
+
+  // A gene is the animal and the color of a part, a genome is the four
+  // genes of a kreature, four bits each.
+  using Gene = uint8_t;
+  using Genome = uint16_t;
+
+  constexpr Gene makeGene(int offset, ColorName color) {
+    return static_cast<Gene>(offset * ColorCount + color);
+  }
+
+  constexpr int getGeneOffset(Gene gene) {
+    return gene / ColorCount;
+  }
+
+  constexpr ColorName getGeneColor(Gene gene) {
+    return static_cast<ColorName>(gene % ColorCount);
+  }
+
+  constexpr Gene getGene(Genome genome, GenomePart part) {
+    return static_cast<Gene>((genome >> (4 * static_cast<int>(part))) & 0xF);
+  }
+
+  constexpr Genome setGene(Genome genome, GenomePart part, Gene gene) {
+    return static_cast<Genome>((genome & ~(0xF << (4 * static_cast<int>(part)))) | (gene << (4 * static_cast<int>(part))));
+  }
+
+  constexpr Genome makeGenome(Gene head, Gene body, Gene limbs, Gene tail) {
+    return static_cast<Genome>(head | (body << 4) | (limbs << 8) | (tail << 12));
+  }
+
+  constexpr Gene KrokodileGene = makeGene(0, Green);
+  constexpr Genome KrokodileGenome = makeGenome(KrokodileGene, KrokodileGene, KrokodileGene, KrokodileGene);
+
+  // ColorDominance[color][other] is 1 if color dominates other, -1 if it
+  // is dominated, 0 otherwise
+  constexpr int8_t ColorDominance[ColorCount][ColorCount] = {
+    //  Azure  Green  Yellow  Red  Magenta
+    {     0,    -1,     1,    -1,     1 }, // Azure
+    {     1,     0,     1,    -1,    -1 }, // Green
+    {    -1,    -1,     0,     1,     1 }, // Yellow
+    {     1,     1,    -1,     0,    -1 }, // Red
+    {    -1,     1,    -1,     1,     0 }, // Magenta
+  };
+
+  constexpr float UpperFusionFactor = 0.75f;
+  constexpr float LowerFusionFactor = 0.25f;
+  constexpr float FumbleMutation = 0.90f;
+
+  // a child gets the color of the other parent above this threshold
+  constexpr float computeFusionThreshold(ColorName color, ColorName other) {
+    return ColorDominance[color][other] == 1 ? UpperFusionFactor : LowerFusionFactor;
+  }
+
+  constexpr float FusionThresholds[ColorCount][ColorCount] = {
+    { computeFusionThreshold(Azure, Azure), computeFusionThreshold(Azure, Green), computeFusionThreshold(Azure, Yellow), computeFusionThreshold(Azure, Red), computeFusionThreshold(Azure, Magenta) },
+    { computeFusionThreshold(Green, Azure), computeFusionThreshold(Green, Green), computeFusionThreshold(Green, Yellow), computeFusionThreshold(Green, Red), computeFusionThreshold(Green, Magenta) },
+    { computeFusionThreshold(Yellow, Azure), computeFusionThreshold(Yellow, Green), computeFusionThreshold(Yellow, Yellow), computeFusionThreshold(Yellow, Red), computeFusionThreshold(Yellow, Magenta) },
+    { computeFusionThreshold(Red, Azure), computeFusionThreshold(Red, Green), computeFusionThreshold(Red, Yellow), computeFusionThreshold(Red, Red), computeFusionThreshold(Red, Magenta) },
+    { computeFusionThreshold(Magenta, Azure), computeFusionThreshold(Magenta, Green), computeFusionThreshold(Magenta, Yellow), computeFusionThreshold(Magenta, Red), computeFusionThreshold(Magenta, Magenta) },
+  };
+
+  static_assert(getGene(KrokodileGenome, GenomePart::Tail) == KrokodileGene, "Genes must fit in four bits");
+  static_assert(makeGene(AnimalCount - 1, Magenta) < 16, "Genes must fit in four bits");
+
+}
+
+#endif // KKD_GENOME_H
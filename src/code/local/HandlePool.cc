@@ -0,0 +1,129 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "HandlePool.h"
+
+#include <cassert>
+
+namespace kkd {
+
+  constexpr HandlePool::Handle HandlePool::InvalidHandle;
+
+  HandlePool::HandlePool(std::size_t capacity)
+  : m_firstFree(NoSlot)
+  {
+    reserve(capacity);
+  }
+
+  void HandlePool::reserve(std::size_t capacity) {
+    if (capacity > m_slots.size()) {
+      addSlots(capacity - m_slots.size());
+    }
+  }
+
+  std::size_t HandlePool::getCapacity() const {
+    return m_slots.size();
+  }
+
+  void HandlePool::clear() {
+    m_firstFree = NoSlot;
+
+    // first slots first, so that a cleared pool allocates in the same order
+    for (std::size_t i = m_slots.size(); i-- > 0; ) {
+      Slot& slot = m_slots[i];
+
+      if (slot.used) {
+        ++slot.generation;
+        slot.used = false;
+      }
+
+      slot.nextFree = m_firstFree;
+      m_firstFree = static_cast<uint32_t>(i);
+    }
+  }
+
+  HandlePool::Handle HandlePool::allocate(std::size_t index) {
+    if (m_firstFree == NoSlot) {
+      addSlots(m_slots.empty() ? 1 : m_slots.size());
+    }
+
+    std::size_t number = m_firstFree;
+    Slot& slot = m_slots[number];
+    m_firstFree = slot.nextFree;
+
+    slot.index = index;
+    slot.nextFree = NoSlot;
+    slot.used = true;
+
+    return makeHandle(number, slot.generation);
+  }
+
+  void HandlePool::release(Handle handle) {
+    assert(isValid(handle));
+    std::size_t number = getSlot(handle);
+    Slot& slot = m_slots[number];
+
+    ++slot.generation;
+    slot.used = false;
+    slot.nextFree = m_firstFree;
+    m_firstFree = static_cast<uint32_t>(number);
+  }
+
+  bool HandlePool::isValid(Handle handle) const {
+    std::size_t number = getSlot(handle);
+
+    if (number >= m_slots.size()) {
+      return false;
+    }
+
+    const Slot& slot = m_slots[number];
+    return slot.used && makeHandle(number, slot.generation) == handle;
+  }
+
+  std::size_t HandlePool::getIndex(Handle handle) const {
+    assert(isValid(handle));
+    return m_slots[getSlot(handle)].index;
+  }
+
+  void HandlePool::setIndex(Handle handle, std::size_t index) {
+    assert(isValid(handle));
+    m_slots[getSlot(handle)].index = index;
+  }
+
+  HandlePool::Handle HandlePool::getHandle(std::size_t slot) const {
+    assert(slot < m_slots.size());
+    assert(m_slots[slot].used);
+    return makeHandle(slot, m_slots[slot].generation);
+  }
+
+  void HandlePool::addSlots(std::size_t count) {
+    std::size_t first = m_slots.size();
+    assert(first + count < NoSlot);
+    m_slots.resize(first + count);
+
+    // the new slots are allocated next, lowest first
+    for (std::size_t i = first + count; i-- > first; ) {
+      Slot& slot = m_slots[i];
+      slot.index = 0;
+      slot.generation = 0;
+      slot.used = false;
+      slot.nextFree = m_firstFree;
+      m_firstFree = static_cast<uint32_t>(i);
+    }
+  }
+
+}
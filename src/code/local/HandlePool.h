@@ -0,0 +1,87 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_HANDLE_POOL_H
+#define KKD_HANDLE_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace kkd {
+
+  // Maps handles to the dense index of an object. A handle is a slot and
+  // the generation of the slot when it was allocated. Released slots are
+  // reused through a free list, and their generation changes, so that an
+  // old handle can be detected.
+  class HandlePool {
+  public:
+    using Handle = uint64_t;
+
+    static constexpr Handle InvalidHandle = std::numeric_limits<Handle>::max();
+
+    // the slots are allocated up front, the pool only grows beyond capacity
+    explicit HandlePool(std::size_t capacity = 0);
+
+    void reserve(std::size_t capacity);
+    std::size_t getCapacity() const;
+
+    // every handle becomes stale
+    void clear();
+
+    Handle allocate(std::size_t index);
+    void release(Handle handle);
+
+    bool isValid(Handle handle) const;
+
+    std::size_t getIndex(Handle handle) const;
+    void setIndex(Handle handle, std::size_t index);
+
+    // the slot is a small integer, suitable to index an array
+    static std::size_t getSlot(Handle handle) {
+      return static_cast<std::size_t>(handle & 0xFFFFFFFF);
+    }
+
+    // the handle currently allocated in the slot
+    Handle getHandle(std::size_t slot) const;
+
+  private:
+    static constexpr uint32_t NoSlot = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+      std::size_t index;
+      uint32_t generation;
+      uint32_t nextFree; // NoSlot if used or last
+      bool used;
+    };
+
+    static Handle makeHandle(std::size_t slot, uint32_t generation) {
+      return (static_cast<Handle>(generation) << 32) | static_cast<Handle>(slot);
+    }
+
+    void addSlots(std::size_t count);
+
+  private:
+    std::vector<Slot> m_slots;
+    uint32_t m_firstFree;
+  };
+
+}
+
+#endif // KKD_HANDLE_POOL_H
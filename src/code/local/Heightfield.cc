@@ -0,0 +1,125 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Heightfield.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <mutex>
+
+#include "Singletons.h"
+
+namespace kkd {
+
+  constexpr std::size_t Heightfield::BandSize;
+  constexpr std::size_t Heightfield::TileSize;
+
+  Heightfield::Heightfield(gf::Vector2i size)
+  : m_size(size)
+  , m_data(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y), 0.0)
+  , m_min(0.0)
+  , m_max(0.0)
+  {
+    assert(size.x > 0 && size.y > 0);
+  }
+
+  gf::Vector2i Heightfield::getSize() const {
+    return m_size;
+  }
+
+  double Heightfield::getValue(gf::Vector2i position) const {
+    assert(0 <= position.x && position.x < m_size.x);
+    assert(0 <= position.y && position.y < m_size.y);
+    return m_data[static_cast<std::size_t>(position.y) * m_size.x + position.x];
+  }
+
+  void Heightfield::setNoise(const PerlinField& field, double scale) {
+    const std::size_t width = m_size.x;
+    std::vector<double> xs(width);
+
+    for (std::size_t x = 0; x < width; ++x) {
+      xs[x] = static_cast<double>(x) / m_size.x * scale;
+    }
+
+    std::mutex mutex;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    auto computeBand = [&](std::size_t begin, std::size_t end) {
+      double bandMin = std::numeric_limits<double>::max();
+      double bandMax = std::numeric_limits<double>::lowest();
+
+      for (std::size_t row = begin; row < end; ++row) {
+        double *values = m_data.data() + row * width;
+        field.computeRow(xs.data(), width, static_cast<double>(row) / m_size.y * scale, values);
+
+        for (std::size_t x = 0; x < width; ++x) {
+          bandMin = std::min(bandMin, values[x]);
+          bandMax = std::max(bandMax, values[x]);
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      min = std::min(min, bandMin);
+      max = std::max(max, bandMax);
+    };
+
+    gWorkerPool().parallelFor(m_size.y, BandSize, computeBand);
+
+    m_min = min;
+    m_max = max;
+  }
+
+  void Heightfield::normalize() {
+    if (m_min == m_max) {
+      std::fill(m_data.begin(), m_data.end(), 0.0);
+      m_max = 0.0;
+      m_min = 0.0;
+      return;
+    }
+
+    // same operations as gf::Heightmap::normalize()
+    const double min = m_min;
+    const double factor = 1.0 / (m_max - m_min);
+
+    auto normalizeTile = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        m_data[i] = (m_data[i] - min) * factor;
+      }
+    };
+
+    gWorkerPool().parallelFor(m_data.size(), TileSize, normalizeTile);
+
+    m_min = 0.0;
+    m_max = 1.0;
+  }
+
+  void Heightfield::computeTiles(int tileTypes, uint8_t *tiles) const {
+    const double factor = tileTypes - 0.000001;
+
+    auto computeTile = [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        assert(0.0 <= m_data[i] && m_data[i] <= 1.0);
+        tiles[i] = static_cast<uint8_t>(m_data[i] * factor);
+      }
+    };
+
+    gWorkerPool().parallelFor(m_data.size(), TileSize, computeTile);
+  }
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_HEIGHTFIELD_H
+#define KKD_HEIGHTFIELD_H
+
+#include <cstdint>
+#include <vector>
+
+#include <gf/Vector.h>
+
+#include "PerlinField.h"
+
+namespace kkd {
+
+  // A heightmap filled on the worker pool: the noise is computed by bands
+  // of rows and the normalization by tiles. The values are the ones of
+  // gf::Heightmap::addNoise() on a reset heightmap, then normalize().
+  // The game streams its map in chunks, it is only built in krokodile-bench.
+  class Heightfield {
+  public:
+    explicit Heightfield(gf::Vector2i size);
+
+    gf::Vector2i getSize() const;
+    double getValue(gf::Vector2i position) const;
+
+    void setNoise(const PerlinField& field, double scale = 1.0);
+
+    // to [0, 1]
+    void normalize();
+
+    // the values in tileTypes tiles, row by row
+    void computeTiles(int tileTypes, uint8_t *tiles) const;
+
+  private:
+    static constexpr std::size_t BandSize = 16; // in rows
+    static constexpr std::size_t TileSize = 16384; // in values
+
+  private:
+    gf::Vector2i m_size;
+    std::vector<double> m_data;
+    double m_min; // of the values, updated by setNoise()
+    double m_max;
+  };
+
+}
+
+#endif // KKD_HEIGHTFIELD_H
@@ -8,35 +8,118 @@
 #include <gf/Text.h>
 #include <gf/VectorOps.h>
 
+#include "AllocationTracker.h"
+#include "Atlas.h"
+#include "FrameProfiler.h"
 #include "Singletons.h"
 
 #define UNUSED(x) (void)(x)
 
 namespace kkd {
 
+  namespace {
+    constexpr float Padding = 15.0f;
+    constexpr float RatioWarning = 0.8f;
+    constexpr float IconSize = 128.0f; // in the atlas
+
+    bool isFoodWarning(float foodLevel) {
+      return foodLevel / 100.0f >= RatioWarning;
+    }
+  }
+
   Hud::Hud()
   : gf::Entity(10)
   , m_font(gResourceManager().getFont("blkchcry.ttf"))
-  , m_clock(gResourceManager().getTexture("clock.png"))
-  , m_gen(gResourceManager().getTexture("gen.png"))
-  , m_heartOk(gResourceManager().getTexture("heart_red.png"))
-  , m_heartLow(gResourceManager().getTexture("heart.png"))
-  , m_penta(gResourceManager().getTexture("penta.png"))
+  , m_atlas(getAtlasPath())
+  , m_genNumber(0)
+  , m_foodLevel(0.0f)
+  , m_pentaBackground(5)
+  , m_screenSize(0u, 0u)
+  , m_displayedGenNumber(-1)
+  , m_displayedSeconds(-1)
+  , m_displayedWarning(false)
+  , m_rebuilds(0)
+  , m_drawCalls(0)
   {
     // register message handler
-    gMessageManager().registerHandler<KrokodileStats>(&Hud::onKrokodileStats, this);
-    m_clock.setSmooth();
-    m_gen.setSmooth();
-    m_heartOk.setSmooth();
-    m_heartLow.setSmooth();
-    m_penta.setSmooth();
+    m_statsSubscription = gMessageBus().subscribe(this, &Hud::onKrokodileStats);
+    m_atlas.setSmooth();
+
+    // GEN INFO
+    m_genSprite.setTexture(m_atlas);
+    m_genSprite.setTextureRect(getAtlasRect(AtlasRegion::Gen));
+    m_genSprite.setAnchor(gf::Anchor::BottomLeft);
+
+    m_genText.setFont(m_font);
+    m_genText.setColor(gf::Color::White);
+    m_genText.setOutlineColor(gf::Color::Black);
+
+    // FOOD INFO
+    m_heartSprite.setTexture(m_atlas);
+    m_heartSprite.setTextureRect(getAtlasRect(AtlasRegion::Heart));
+    m_heartSprite.setAnchor(gf::Anchor::BottomLeft);
+
+    // Timer
+    m_clockSprite.setTexture(m_atlas);
+    m_clockSprite.setTextureRect(getAtlasRect(AtlasRegion::Clock));
+    m_clockSprite.setPosition({ Padding, Padding });
+
+    m_timerText.setFont(m_font);
+    m_timerText.setColor(gf::Color::White);
+    m_timerText.setOutlineColor(gf::Color::Black);
+
+    // PENTA COLOR
+    m_pentaSprite.setTexture(m_atlas);
+    m_pentaSprite.setTextureRect(getAtlasRect(AtlasRegion::Penta));
+    m_pentaSprite.setAnchor(gf::Anchor::BottomRight);
+
+    m_pentaBackground.setPoint(0, { IconSize * 0.5f, IconSize * 0.0f });
+    m_pentaBackground.setPoint(1, { IconSize * 1.0f, IconSize * 0.28f });
+    m_pentaBackground.setPoint(2, { IconSize * 0.83f, IconSize * 1.0f });
+    m_pentaBackground.setPoint(3, { IconSize * 0.19f, IconSize * 1.0f });
+    m_pentaBackground.setPoint(4, { IconSize * 0.0f,  IconSize * 0.28f });
+
+    m_pentaBackground.setOutlineThickness(5.0f);
+    m_pentaBackground.setOutlineColor(gf::Color::Opaque(0.3f));
+    m_pentaBackground.setColor(gf::Color::Opaque(0.6f));
+    m_pentaBackground.setAnchor(gf::Anchor::BottomRight);
   }
 
   void Hud::render(gf::RenderTarget& target, const gf::RenderStates& states)
   {
     UNUSED(states);
-    static constexpr float Padding = 15.0f;
-    static constexpr float RatioWarning = 0.8f;
+    AllocationTracker::Scope allocationScope(Subsystem::Hud);
+    FrameProfiler::Zone zone("Hud::render");
+
+    m_rebuilds = 0;
+
+    if (target.getSize() != m_screenSize) {
+      updateLayout(target);
+    }
+
+    updateTexts();
+
+    // DRAW EVERYTHING
+    gf::Drawable *drawables[] = { &m_genText, &m_timerText, &m_clockSprite, &m_genSprite, &m_heartSprite, &m_pentaBackground, &m_pentaSprite };
+    m_drawCalls = 0;
+
+    for (auto drawable : drawables) {
+      target.draw(*drawable);
+      ++m_drawCalls;
+    }
+  }
+
+  std::size_t Hud::getRebuildCount() const {
+    return m_rebuilds;
+  }
+
+  std::size_t Hud::getDrawCallCount() const {
+    return m_drawCalls;
+  }
+
+  void Hud::updateLayout(gf::RenderTarget& target) {
+    m_screenSize = target.getSize();
+    ++m_rebuilds;
 
     gf::Coordinates coords(target);
 
@@ -44,89 +127,77 @@ namespace kkd {
     gf::Vector2f pentaPos = coords.getAbsolutePoint({ Padding, Padding }, gf::Anchor::BottomRight);
 
     unsigned characterSize = coords.getRelativeCharacterSize(0.08f);
-    float HudIconsScale = characterSize / 128.0f / 1.25f;
+    float HudIconsScale = characterSize / IconSize / 1.25f;
 
     // GEN INFO
-    gf::Sprite genSprite;
-    genSprite.setTexture(m_gen);
-    genSprite.setPosition(genPos);
-    genSprite.setScale(HudIconsScale);
-    genSprite.setAnchor(gf::Anchor::BottomLeft);
-
-    gf::Text genText(std::to_string(m_genNumber), m_font, characterSize);
-    genText.setColor(gf::Color::White);
-    genText.setOutlineColor(gf::Color::Black);
-    genText.setOutlineThickness(characterSize / 30.0f);
-    genText.setPosition({genPos.x + genSprite.getLocalBounds().width * HudIconsScale + Padding, genPos.y});
-    genText.setAnchor(gf::Anchor::BottomLeft);
+    m_genSprite.setPosition(genPos);
+    m_genSprite.setScale(HudIconsScale);
+
+    m_genText.setCharacterSize(characterSize);
+    m_genText.setOutlineThickness(characterSize / 30.0f);
+    m_genText.setPosition({genPos.x + m_genSprite.getLocalBounds().width * HudIconsScale + Padding, genPos.y});
 
     // FOOD INFO
-    gf::Sprite heartSprite;
-    if (m_foodLevel / 100.0f < RatioWarning) {
-      heartSprite.setTexture(m_heartLow);
-    } else {
-      heartSprite.setTexture(m_heartOk);
-    }
-    heartSprite.setScale(HudIconsScale);
-    heartSprite.setPosition({ genPos.x, genPos.y - genSprite.getLocalBounds().height * HudIconsScale });
-    heartSprite.setAnchor(gf::Anchor::BottomLeft);
+    m_heartSprite.setScale(HudIconsScale);
+    m_heartSprite.setPosition({ genPos.x, genPos.y - m_genSprite.getLocalBounds().height * HudIconsScale });
 
     // Timer
-    gf::Sprite clockSprite;
-    clockSprite.setTexture(m_clock);
-    clockSprite.setScale(HudIconsScale);
-    clockSprite.setPosition({ Padding, Padding });
-
-    gf::Text timer(std::to_string(static_cast<int>(m_time.getElapsedTime().asSeconds())), m_font, characterSize);
-    timer.setColor(gf::Color::White);
-    timer.setOutlineColor(gf::Color::Black);
-    timer.setOutlineThickness(characterSize / 30.0f);
-    timer.setPosition({ 2.0f * Padding + clockSprite.getLocalBounds().width * HudIconsScale, Padding });
-    timer.setAnchor(gf::Anchor::TopLeft);
+    m_clockSprite.setScale(HudIconsScale);
+
+    m_timerText.setCharacterSize(characterSize);
+    m_timerText.setOutlineThickness(characterSize / 30.0f);
+    m_timerText.setPosition({ 2.0f * Padding + m_clockSprite.getLocalBounds().width * HudIconsScale, Padding });
 
     // PENTA COLOR
-    gf::Sprite pentaSprite;
-    pentaSprite.setTexture(m_penta);
-    pentaSprite.setScale(HudIconsScale * 3.0f);
-    pentaSprite.setPosition(pentaPos);
-    pentaSprite.setAnchor(gf::Anchor::BottomRight);
-
-    gf::ConvexShape pentaBackground(5);
-    pentaBackground.setPoint(0, { 128.0f * 0.5f, 128.0f * 0.0f });
-    pentaBackground.setPoint(1, { 128.0f * 1.0f, 128.0f * 0.28f });
-    pentaBackground.setPoint(2, { 128.0f * 0.83f, 128.0f * 1.0f });
-    pentaBackground.setPoint(3, { 128.0f * 0.19f, 128.0f * 1.0f });
-    pentaBackground.setPoint(4, { 128.0f * 0.0f,  128.0f * 0.28f });
-
-    pentaBackground.setOutlineThickness(5.0f);
-    pentaBackground.setOutlineColor(gf::Color::Opaque(0.3f));
-    pentaBackground.setColor(gf::Color::Opaque(0.6f));
-    pentaBackground.setScale(HudIconsScale * 3.0f);
-    pentaBackground.setPosition(pentaPos);
-    pentaBackground.setAnchor(gf::Anchor::BottomRight);
+    m_pentaSprite.setScale(HudIconsScale * 3.0f);
+    m_pentaSprite.setPosition(pentaPos);
 
-    // DRAW EVERYTHING
-    target.draw(genText);
-    target.draw(timer);
-    target.draw(clockSprite);
-    target.draw(genSprite);
-    target.draw(heartSprite);
-    target.draw(pentaBackground);
-    target.draw(pentaSprite);
+    m_pentaBackground.setScale(HudIconsScale * 3.0f);
+    m_pentaBackground.setPosition(pentaPos);
+
+    // the anchor of a text depends on its bounds
+    m_genText.setAnchor(gf::Anchor::BottomLeft);
+    m_timerText.setAnchor(gf::Anchor::TopLeft);
   }
 
-  void Hud::reset() {
-    m_time.restart();
+  void Hud::updateTexts() {
+    if (m_genNumber != m_displayedGenNumber) {
+      m_displayedGenNumber = m_genNumber;
+      m_genText.setString(std::to_string(m_genNumber));
+      m_genText.setAnchor(gf::Anchor::BottomLeft);
+      ++m_rebuilds;
+    }
+
+    int seconds = static_cast<int>(m_time.getElapsedTime().asSeconds());
+
+    if (seconds != m_displayedSeconds) {
+      m_displayedSeconds = seconds;
+      m_timerText.setString(std::to_string(seconds));
+      m_timerText.setAnchor(gf::Anchor::TopLeft);
+      ++m_rebuilds;
+    }
+
+    bool warning = isFoodWarning(m_foodLevel);
+
+    if (warning != m_displayedWarning) {
+      m_displayedWarning = warning;
+      m_heartSprite.setTextureRect(getAtlasRect(warning ? AtlasRegion::HeartRed : AtlasRegion::Heart));
+      m_heartSprite.setAnchor(gf::Anchor::BottomLeft);
+      ++m_rebuilds;
+    }
   }
 
-  gf::MessageStatus Hud::onKrokodileStats(gf::Id id, gf::Message *msg) {
-    assert(id == KrokodileStats::type);
-    KrokodileStats *stats = static_cast<KrokodileStats*>(msg);
+  Hud::~Hud() {
+    gMessageBus().unsubscribe(m_statsSubscription);
+  }
 
-    m_genNumber = stats->ageLevel;
-    m_foodLevel = stats->foodLevel;
+  void Hud::reset() {
+    m_time.restart();
+  }
 
-    return gf::MessageStatus::Keep;
+  void Hud::onKrokodileStats(const KrokodileStats& message) {
+    m_genNumber = message.ageLevel;
+    m_foodLevel = message.foodLevel;
   }
 
 }
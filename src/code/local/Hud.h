@@ -1,38 +1,71 @@
 #ifndef KKD_HUD_H
 #define KKD_HUD_H
 
+#include <cstddef>
+
 #include <gf/Entity.h>
 #include <gf/Font.h>
 #include <gf/RenderTarget.h>
 #include <gf/Shapes.h>
+#include <gf/Sprite.h>
+#include <gf/Text.h>
+#include <gf/Texture.h>
 #include <gf/Clock.h>
 
+#include "local/MessageBus.h"
 #include "local/Messages.h"
 
 namespace kkd {
+  // The drawables are kept between frames. The layout is only computed
+  // again when the screen size changes, and a text only when its value
+  // changes.
   class Hud: public gf::Entity {
   public:
     Hud();
+    ~Hud();
 
     void reset();
 
     virtual void render(gf::RenderTarget& target, const gf::RenderStates& states) override;
 
-    gf::MessageStatus onKrokodileStats(gf::Id id, gf::Message *msg);
+    void onKrokodileStats(const KrokodileStats& message);
+
+    // layouts and texts rebuilt by the last render
+    std::size_t getRebuildCount() const;
+
+    // number of drawables submitted by the last render
+    std::size_t getDrawCallCount() const;
+
+  private:
+    void updateLayout(gf::RenderTarget& target);
+    void updateTexts();
 
   private:
     gf::Font &m_font;
-    gf::Texture &m_clock;
-    gf::Texture &m_gen;
-    gf::Texture &m_heartOk;
-    gf::Texture &m_heartLow;
-    gf::Texture &m_penta;
+    MessageBus::SubscriptionId m_statsSubscription;
+    gf::Texture m_atlas; // smoothed copy of the shared atlas
     int m_genNumber;
     gf::Clock m_time;
     float m_foodLevel;
 
     gf::RectangleShape m_maxFood;
     gf::RectangleShape m_currentFood;
+
+    gf::Sprite m_genSprite;
+    gf::Text m_genText;
+    gf::Sprite m_heartSprite;
+    gf::Sprite m_clockSprite;
+    gf::Text m_timerText;
+    gf::Sprite m_pentaSprite;
+    gf::ConvexShape m_pentaBackground;
+
+    // what is displayed
+    gf::Vector2u m_screenSize;
+    int m_displayedGenNumber;
+    int m_displayedSeconds;
+    bool m_displayedWarning;
+    std::size_t m_rebuilds;
+    std::size_t m_drawCalls;
   };
 }
 
@@ -0,0 +1,299 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "InputRecord.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "KreatureContainer.h"
+
+namespace kkd {
+
+  constexpr uint32_t InputRecorder::Version;
+
+  namespace {
+    const char Magic[4] = { 'K', 'K', 'D', 'I' };
+
+    enum Button : uint8_t {
+      DirectionMask = 0x03,
+      Sprint = 0x10,
+      Swap = 0x20,
+      Fusion = 0x40,
+      Krokodile = 0x80,
+    };
+
+    // the direction code that is never written, it marks the end
+    constexpr uint8_t End = DirectionMask;
+
+    uint8_t encodeDirection(int direction) {
+      return direction > 0 ? 1 : (direction < 0 ? 2 : 0);
+    }
+
+    int decodeDirection(uint8_t bits) {
+      return bits == 1 ? 1 : (bits == 2 ? -1 : 0);
+    }
+
+    void writeByte(std::ostream& out, uint8_t value) {
+      out.put(static_cast<char>(value));
+    }
+
+    void writeInteger(std::ostream& out, uint64_t value, int bytes) {
+      for (int i = 0; i < bytes; ++i) {
+        writeByte(out, static_cast<uint8_t>(value >> (8 * i)));
+      }
+    }
+
+    void writeVarint(std::ostream& out, uint64_t value) {
+      while (value >= 0x80) {
+        writeByte(out, static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+      }
+
+      writeByte(out, static_cast<uint8_t>(value));
+    }
+
+    void writeFloat(std::ostream& out, float value) {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      writeInteger(out, bits, 4);
+    }
+
+    bool readByte(std::istream& in, uint8_t& value) {
+      char c;
+
+      if (!in.get(c)) {
+        return false;
+      }
+
+      value = static_cast<uint8_t>(c);
+      return true;
+    }
+
+    bool readInteger(std::istream& in, uint64_t& value, int bytes) {
+      value = 0;
+
+      for (int i = 0; i < bytes; ++i) {
+        uint8_t byte;
+
+        if (!readByte(in, byte)) {
+          return false;
+        }
+
+        value |= static_cast<uint64_t>(byte) << (8 * i);
+      }
+
+      return true;
+    }
+
+    bool readVarint(std::istream& in, uint64_t& value) {
+      value = 0;
+
+      for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+
+        if (!readByte(in, byte)) {
+          return false;
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool readFloat(std::istream& in, float& value) {
+      uint64_t bits;
+
+      if (!readInteger(in, bits, 4)) {
+        return false;
+      }
+
+      uint32_t bits32 = static_cast<uint32_t>(bits);
+      std::memcpy(&value, &bits32, sizeof(value));
+      return true;
+    }
+  }
+
+  void applyPlayerInput(const InputFrame& input, KreatureContainer& kreatures) {
+    kreatures.playerSprint(input.sprint);
+
+    // the directions are held until the next frame, whatever the number of updates
+    kreatures.playerSidedMove(input.side);
+    kreatures.playerForwardMove(input.forward);
+
+    if (input.swap) {
+      kreatures.swapKreature();
+    }
+  }
+
+  InputRecorder::InputRecorder()
+  : m_frames(0)
+  {
+  }
+
+  bool InputRecorder::open(const std::string& filename, uint64_t seed) {
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+
+    if (!m_file) {
+      return false;
+    }
+
+    m_file.write(Magic, sizeof(Magic));
+    writeInteger(m_file, Version, 4);
+    writeInteger(m_file, seed, 8);
+    m_frames = 0;
+    return static_cast<bool>(m_file);
+  }
+
+  bool InputRecorder::isOpen() const {
+    return m_file.is_open();
+  }
+
+  void InputRecorder::record(const InputFrame& input) {
+    if (!m_file.is_open()) {
+      return;
+    }
+
+    uint8_t buttons = encodeDirection(input.forward) | (encodeDirection(input.side) << 2);
+
+    if (input.sprint) {
+      buttons |= Sprint;
+    }
+
+    if (input.swap) {
+      buttons |= Swap;
+    }
+
+    if (input.fusion) {
+      buttons |= Fusion;
+    }
+
+    if (input.krokodile) {
+      buttons |= Krokodile;
+    }
+
+    // all the bits of the buttons are used, the view size flag is the low
+    // bit of the time
+    uint64_t microseconds = static_cast<uint64_t>(std::max(input.time.asMicroseconds(), int64_t(0)));
+
+    writeByte(m_file, buttons);
+    writeVarint(m_file, (microseconds << 1) | (input.hasViewSize ? 1 : 0));
+
+    if (input.hasViewSize) {
+      writeFloat(m_file, input.viewSize.x);
+      writeFloat(m_file, input.viewSize.y);
+    }
+
+    ++m_frames;
+  }
+
+  void InputRecorder::close(uint64_t stateHash) {
+    if (!m_file.is_open()) {
+      return;
+    }
+
+    writeByte(m_file, End);
+    writeInteger(m_file, m_frames, 8);
+    writeInteger(m_file, stateHash, 8);
+    m_file.close();
+  }
+
+  InputReplay::InputReplay()
+  : m_seed(0)
+  , m_complete(false)
+  , m_frames(0)
+  , m_stateHash(0)
+  {
+  }
+
+  bool InputReplay::open(const std::string& filename) {
+    m_file.open(filename, std::ios::binary);
+
+    if (!m_file) {
+      return false;
+    }
+
+    char magic[sizeof(Magic)];
+    uint64_t version;
+
+    if (!m_file.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0) {
+      return false;
+    }
+
+    if (!readInteger(m_file, version, 4) || version != InputRecorder::Version) {
+      return false;
+    }
+
+    return readInteger(m_file, m_seed, 8);
+  }
+
+  uint64_t InputReplay::getSeed() const {
+    return m_seed;
+  }
+
+  bool InputReplay::next(InputFrame& input) {
+    uint8_t buttons;
+
+    if (m_complete || !readByte(m_file, buttons)) {
+      return false;
+    }
+
+    if ((buttons & DirectionMask) == End) {
+      m_complete = readInteger(m_file, m_frames, 8) && readInteger(m_file, m_stateHash, 8);
+      return false;
+    }
+
+    uint64_t time;
+
+    if (!readVarint(m_file, time)) {
+      return false;
+    }
+
+    input.time = gf::microseconds(static_cast<int64_t>(time >> 1));
+    input.forward = decodeDirection(buttons & DirectionMask);
+    input.side = decodeDirection((buttons >> 2) & DirectionMask);
+    input.sprint = (buttons & Sprint) != 0;
+    input.swap = (buttons & Swap) != 0;
+    input.fusion = (buttons & Fusion) != 0;
+    input.krokodile = (buttons & Krokodile) != 0;
+    input.hasViewSize = (time & 1) != 0;
+
+    if (input.hasViewSize) {
+      return readFloat(m_file, input.viewSize.x) && readFloat(m_file, input.viewSize.y);
+    }
+
+    return true;
+  }
+
+  bool InputReplay::isComplete() const {
+    return m_complete;
+  }
+
+  uint64_t InputReplay::getFrameCount() const {
+    return m_frames;
+  }
+
+  uint64_t InputReplay::getStateHash() const {
+    return m_stateHash;
+  }
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_INPUT_RECORD_H
+#define KKD_INPUT_RECORD_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include <gf/Time.h>
+#include <gf/Vector.h>
+
+namespace kkd {
+  class KreatureContainer;
+
+  // What the player did during a frame, as read from the actions
+  struct InputFrame {
+    gf::Time time; // since the last frame
+    int forward; // 1 to forward / -1 to backward
+    int side; // 1 to right / -1 to left
+    bool sprint;
+    bool swap;
+    bool fusion; // or restart, when the game is complete
+    bool krokodile; // the easter egg
+    bool hasViewSize; // the view size changed
+    gf::Vector2f viewSize;
+  };
+
+  // the movement, the sprint and the swap, the same in the game and in a
+  // replay
+  void applyPlayerInput(const InputFrame& input, KreatureContainer& kreatures);
+
+  // A session is the seed of gRandom, then a record per frame: a byte for
+  // the actions, a varint of the time in microseconds with the view size
+  // flag in its low bit, and the view size (8 bytes) when it changes.
+  // That is 4 bytes for a frame up to one second, 12 with a view size.
+  // The number of frames and the hash of the kreatures come at the end.
+  // The values are in little endian.
+  class InputRecorder {
+  public:
+    static constexpr uint32_t Version = 2;
+
+    InputRecorder();
+
+    bool open(const std::string& filename, uint64_t seed);
+    bool isOpen() const;
+
+    void record(const InputFrame& input);
+
+    // the hash of the kreatures once the last frame is played
+    void close(uint64_t stateHash);
+
+  private:
+    std::ofstream m_file;
+    uint64_t m_frames;
+  };
+
+  class InputReplay {
+  public:
+    InputReplay();
+
+    bool open(const std::string& filename);
+
+    uint64_t getSeed() const;
+
+    // false at the end of the session, or when the file is truncated
+    bool next(InputFrame& input);
+
+    // known once next() returned false
+    bool isComplete() const;
+    uint64_t getFrameCount() const;
+    uint64_t getStateHash() const;
+
+  private:
+    std::ifstream m_file;
+    uint64_t m_seed;
+    bool m_complete;
+    uint64_t m_frames;
+    uint64_t m_stateHash;
+  };
+
+}
+
+#endif // KKD_INPUT_RECORD_H
@@ -18,65 +18,140 @@
 
 #include "KreatureContainer.h"
 
-#include <numeric>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 #include <gf/Color.h>
 #include <gf/Log.h>
 #include <gf/Math.h>
-#include <gf/Shapes.h>
-#include <gf/Sprite.h>
-#include <gf/Transform.h>
+#include <gf/RenderTarget.h>
+#include <gf/Vertex.h>
 
+#include "AllocationTracker.h"
+#include "Atlas.h"
+#include "FrameProfiler.h"
 #include "Messages.h"
 
 namespace kkd {
-  static constexpr int TotalAnimal = 3;
+  static constexpr gf::Vector2f BodySpriteSize = { 256.0f, 256.0f };
+  static constexpr gf::Vector2f BodyWorldSize = { 128.0f, 128.0f };
+  static constexpr gf::Vector2f HeadSpriteSize = { 256.0f, 256.0f };
+  static constexpr gf::Vector2f HeadWorldSize = { 128.0f, 128.0f };
+  static constexpr gf::Vector2f AnteLegSpriteSize = { 128.0f, 128.0f };
+  static constexpr gf::Vector2f AnteLegWorldSize = { 64.0f, 64.0f };
+  static constexpr gf::Vector2f PostLegSpriteSize = { 128.0f, 128.0f };
+  static constexpr gf::Vector2f PostLegWorldSize = { 64.0f, 64.0f };
+  static constexpr gf::Vector2f TailSpriteSize = { 256.0f, 256.0f };
+  static constexpr gf::Vector2f TailWorldSize = { 128.0f, 128.0f };
+
+  static constexpr gf::Time NoLifeEnd = gf::microseconds(std::numeric_limits<int64_t>::max()); // the krokodile
 
   namespace {
-    gf::Color4f getKreatureColor(KreatureContainer::ColorName ith) {
-      switch (ith) {
-        case KreatureContainer::Azure:
-          return gf::Color::Azure;
-        case KreatureContainer::Green:
-          return gf::Color::Green;
-        case KreatureContainer::Yellow:
-          return gf::Color::lighter(gf::Color::Yellow, 0.25f);
-        case KreatureContainer::Red:
-          return gf::Color::lighter(gf::Color::Red, 0.25f);
-        case KreatureContainer::Magenta:
-          return gf::Color::lighter(gf::Color::Magenta, 0.25f);
-        default:
-          break;
-      }
+    // computed once, not for every sprite
+    const std::array<gf::Color4f, ColorCount>& getPalette() {
+      static const std::array<gf::Color4f, ColorCount> palette = {{
+        gf::Color::Azure,
+        gf::Color::Green,
+        gf::Color::lighter(gf::Color::Yellow, 0.25f),
+        gf::Color::lighter(gf::Color::Red, 0.25f),
+        gf::Color::lighter(gf::Color::Magenta, 0.25f),
+      }};
+
+      return palette;
+    }
 
-      assert(false);
-      return gf::Color::Black;
+    float interpolateAngle(float from, float to, float alpha) {
+      return from + alpha * std::remainder(to - from, 2 * gf::Pi);
     }
 
-    KreatureContainer::ColorName randomColor() {
-      return static_cast<KreatureContainer::ColorName>(gRandom().computeUniformInteger(0, 4));
+    ColorName randomColor() {
+      return static_cast<ColorName>(gRandom().computeUniformInteger(0, ColorCount - 1));
     }
 
     int randomOffset() {
-      return gRandom().computeUniformInteger(0, TotalAnimal - 1);
+      return gRandom().computeUniformInteger(0, AnimalCount - 1);
+    }
+
+    // same geometry as a gf::Sprite showing one animal of a part strip
+    void writePartQuad(gf::Vertex *quad, const gf::RectF& strip, gf::Vector2f size, int offset, gf::Color4f color, gf::Vector2f anchor, gf::Vector2f scale, gf::Vector2f position, float rotation) {
+      float cos = std::cos(rotation);
+      float sin = std::sin(rotation);
+      gf::Vector2f origin = anchor * size;
+
+      auto toWorld = [&](gf::Vector2f local) {
+        local = scale * (local - origin);
+        return position + gf::Vector2f(cos * local.x - sin * local.y, sin * local.x + cos * local.y);
+      };
+
+      float animalWidth = strip.width / AnimalCount;
+      float left = strip.left + offset * animalWidth;
+      float right = left + animalWidth;
+      float top = strip.top;
+      float bottom = strip.top + strip.height;
+
+      gf::Vertex topLeft;
+      topLeft.position = toWorld({ 0.0f, 0.0f });
+      topLeft.texCoords = { left, top };
+      topLeft.color = color;
+
+      gf::Vertex topRight;
+      topRight.position = toWorld({ size.x, 0.0f });
+      topRight.texCoords = { right, top };
+      topRight.color = color;
+
+      gf::Vertex bottomLeft;
+      bottomLeft.position = toWorld({ 0.0f, size.y });
+      bottomLeft.texCoords = { left, bottom };
+      bottomLeft.color = color;
+
+      gf::Vertex bottomRight;
+      bottomRight.position = toWorld(size);
+      bottomRight.texCoords = { right, bottom };
+      bottomRight.color = color;
+
+      quad[0] = topLeft;
+      quad[1] = topRight;
+      quad[2] = bottomLeft;
+      quad[3] = bottomLeft;
+      quad[4] = topRight;
+      quad[5] = bottomRight;
     }
 
   }
 
-  KreatureContainer::KreatureContainer()
-  : m_kreatureHeadTexture(gResourceManager().getTexture("kreature_head.png"))
-  , m_kreaturePostLegTexture(gResourceManager().getTexture("kreature_postleg.png"))
-  , m_kreatureAnteLegTexture(gResourceManager().getTexture("kreature_anteleg.png"))
-  , m_kreatureBodyTexture(gResourceManager().getTexture("kreature_body.png"))
-  , m_kreatureTailTexture(gResourceManager().getTexture("kreature_tail.png"))
-  , m_isSprinting(false) {
+  constexpr gf::Time KreatureContainer::RotationDuration;
+  constexpr gf::Time KreatureContainer::AnimationDuration;
+
+  KreatureContainer::KreatureContainer(std::size_t population)
+  : m_player(HandlePool::InvalidHandle)
+  , m_previousPlayerOrientation(0.0f)
+  , m_seed(0)
+  , m_tick(0)
+  , m_grid(gf::RectF({ MinBound, MinBound }, { MaxBound - MinBound, MaxBound - MinBound }), GridCellSize)
+  , m_spawner(gf::RectF({ MinBound, MinBound }, { MaxBound - MinBound, MaxBound - MinBound }), SpawnBudget)
+  , m_atlasTexture(nullptr)
+  , m_forwardMove(0.0f)
+  , m_sideMove(0.0f)
+  , m_spawnLimit(std::max(population, std::size_t(2)))
+  , m_minimumPopulation(std::max(m_spawnLimit * MinimumPopulation / SpawnLimit, std::size_t(2)))
+  , m_isSprinting(false)
+  , m_interpolation(1.0f)
+  , m_cullingPadding(0.0f)
+  , m_drawCalls(0)
+  , m_visibleCount(0)
+  , m_culledCount(0)
+  , m_spawnCount(0)
+  , m_despawnCount(0) {
     // register message handler
-    gMessageManager().registerHandler<ViewSize>(&KreatureContainer::onSizeView, this);
+    m_viewSizeSubscription = gMessageBus().subscribe(this, &KreatureContainer::onSizeView);
 
     static constexpr gf::Vector2f BoxCropsVoid = { 10.0f, 10.0f };
 
     // Define hacks for sprites
-    m_cropBoxes.resize(TotalAnimal);
+    m_cropBoxes.resize(AnimalCount);
 
     // Joint point for kroko
     m_cropBoxes[0][0] = { 128.0f + BoxCropsVoid.x, 0.0f };
@@ -106,15 +181,46 @@ namespace kkd {
     // m_cropBoxs[0] = gf::RectF({ 0.0f, 0.0f }, { 128.0f, 135.0f });
     // m_cropBoxs[1] = gf::RectF({ 0.0f, 0.0f }, { 116.0f, 170.0f });
 
+    // A part is attached to a joint and can not go further than its
+    // diagonal, so this padding covers every part of a kreature around
+    // its position.
+    float largestPart = 0.0f;
+
+    for (auto size : { BodyWorldSize, HeadWorldSize, AnteLegWorldSize, PostLegWorldSize, TailWorldSize }) {
+      largestPart = std::max(largestPart, gf::euclideanLength(size));
+    }
+
+    float farthestJoint = 0.0f;
+
+    for (auto& joints : m_cropBoxes) {
+      for (auto joint : joints) {
+        farthestJoint = std::max(farthestJoint, gf::euclideanLength(BodyWorldSize / BodySpriteSize * joint));
+      }
+    }
+
+    m_cullingPadding = farthestJoint + largestPart;
+
+    m_spawner.setBudget(std::max(std::size_t(SpawnBudget), m_minimumPopulation / SpawnBudgetRatio));
+
+    // the AI streams of the kreatures derive from it
+    m_seed = gRandom().computeNext();
+
+    // no allocation when kreatures die and respawn
+    reserveKreatures(PoolCapacityFactor * m_spawnLimit);
+
     resetKreatures();
   }
 
+  KreatureContainer::~KreatureContainer() {
+    gMessageBus().unsubscribe(m_viewSizeSubscription);
+  }
+
   void KreatureContainer::playerForwardMove(int direction) {
-    getPlayer().forwardMove = direction;
+    m_forwardMove = direction;
   }
 
   void KreatureContainer::playerSidedMove(int direction) {
-    getPlayer().sideMove = direction;
+    m_sideMove = direction;
   }
 
   void KreatureContainer::playerSprint(bool sprint) {
@@ -122,81 +228,100 @@ namespace kkd {
   }
 
   void KreatureContainer::swapKreature() {
-    assert(m_kreatures.size() >= 2);
+    assert(m_handles.size() >= 2);
 
-    auto& newKreature = getCloserKreature();
+    std::size_t newIndex = getCloserKreature();
 
-    // Reset the activity for the old kreature
-    resetActivities(getPlayer());
+    // The old kreature walks again from where it is
+    startMovement(getPlayerIndex(), m_clock);
 
-    std::swap(getPlayerPtr(), newKreature);
+    setPlayer(m_handles[newIndex]);
 
     checkComplete();
   }
 
   void KreatureContainer::fusionDNA() {
-    assert(m_kreatures.size() >= 2);
+    assert(m_handles.size() >= 2);
 
-    auto& closerKreature = getCloserKreature();
-    auto& currentKreature = getPlayerPtr();
+    std::size_t currentIndex = getPlayerIndex();
+
+    if (m_ageLevels[currentIndex] <= 0 || m_foodLevels[currentIndex] < FusionFoodConsumption) {
+      return;
+    }
+
+    std::size_t closerSlot = m_grid.queryNearest(m_positions[currentIndex], LimitLengthFusion, HandlePool::getSlot(m_player));
 
     // If the kreatures is too for
-    if (gf::euclideanDistance(closerKreature->position, currentKreature->position) > LimitLengthFusion || currentKreature->ageLevel <= 0 || currentKreature->foodLevel < FusionFoodConsumption) {
+    if (closerSlot == SpatialGrid::InvalidId) {
       return;
     }
 
+    Handle closerHandle = m_pool.getHandle(closerSlot);
+
     // Create the child
-    auto newPosition = currentKreature->position + gf::Vector2f(100.0f, 100.0f);
+    auto newPosition = m_positions[currentIndex] + gf::Vector2f(100.0f, 100.0f);
     float xTarget = gRandom().computeUniformFloat(MinBound, MaxBound);
     float yTarget = gRandom().computeUniformFloat(MinBound, MaxBound);
 
     float rotation = gRandom().computeUniformFloat(0.0f, 2 * gf::Pi);
-    auto child = std::make_unique<Kreature>(newPosition, rotation, gf::Vector2f(xTarget, yTarget));
-
-    // Body fusion
-    child->body = fusionPart(currentKreature->body, closerKreature->body);
-
-    // Body head
-    child->head = fusionPart(currentKreature->head, closerKreature->head);
+    Handle child = spawnKreature(newPosition, rotation, gf::Vector2f(xTarget, yTarget));
 
-    // Body tail
-    child->tail = fusionPart(currentKreature->tail, closerKreature->tail);
+    // the arrays may have grown, refresh the indices
+    std::size_t childIndex = getIndex(child);
+    currentIndex = getPlayerIndex();
+    std::size_t closerIndex = getIndex(closerHandle);
 
-    // Body limbs
-    child->limbs = fusionPart(currentKreature->limbs, closerKreature->limbs);
-
-    child->timeElapsed = gf::seconds(0.0f + gRandom().computeUniformFloat(0.01f, AnimationDuration.asSeconds() - 0.01f));
-    child->lifeCountdown = gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime));
+    m_genomes[childIndex] = fusionGenome(m_genomes[currentIndex], m_genomes[closerIndex]);
 
+    setLifeTime(child, gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime)));
 
     addFoodLevel(-FusionFoodConsumption);
 
-    int age = --(currentKreature->ageLevel);
-    --(closerKreature->ageLevel);
+    int age = --m_ageLevels[currentIndex];
+
+    if (--m_ageLevels[closerIndex] <= 0) {
+      m_dyingHandles.push_back(closerHandle);
+    }
 
-    m_kreatures.push_back(std::move(child));
     if (age <= 0) {
-      std::iter_swap(m_kreatures.begin(), m_kreatures.end()-1);
+      m_dyingHandles.push_back(m_player);
+      setPlayer(child);
     }
     removeDeadKreature();
     checkComplete();
   }
 
   void KreatureContainer::removeDeadKreature() {
-    m_kreatures.erase( std::remove_if(m_kreatures.begin(),
-                                      m_kreatures.end(),
-      [this](auto &k) {
-        gf::RectF viewBox({ k->position - 0.5f * gf::Vector2f(400.0f, 400.0f) }, { 400.0f, 400.0f });
-        return !m_viewRect.intersects(viewBox) && (k->ageLevel <= 0 || k->lifeCountdown.asSeconds() <= 0.0f);
-      }), m_kreatures.end());
+    // a dead kreature stays until it is out of sight
+    std::size_t i = 0;
+
+    while (i < m_dyingHandles.size()) {
+      Handle handle = m_dyingHandles[i];
+      bool gone = !m_pool.isValid(handle); // already removed through another cause
+
+      if (!gone && handle != m_player) {
+        gf::Vector2f position = m_positions[getIndex(handle)];
+        gf::RectF viewBox({ position - 0.5f * gf::Vector2f(400.0f, 400.0f) }, { 400.0f, 400.0f });
+
+        if (!m_viewRect.intersects(viewBox)) {
+          despawnKreature(getIndex(handle));
+          gone = true;
+        }
+      }
+
+      if (gone) {
+        m_dyingHandles[i] = m_dyingHandles.back();
+        m_dyingHandles.pop_back();
+      } else {
+        ++i;
+      }
+    }
   }
 
   void KreatureContainer::checkComplete() {
-    auto& player = getPlayer();
-
-    if (player.head.canBeK() && player.body.canBeK() && player.limbs.canBeK() && player.tail.canBeK()) {
+    if (m_genomes[getPlayerIndex()] == KrokodileGenome) {
       CompleteGame msg;
-      gMessageManager().sendMessage(&msg);
+      gMessageBus().post(msg);
     }
   }
 
@@ -209,25 +334,31 @@ namespace kkd {
 
     float rotation = gRandom().computeUniformFloat(0.0f, 2 * gf::Pi);
 
-    auto kreature = std::make_unique<Kreature>(gf::Vector2f(x, y), rotation, gf::Vector2f(xTarget, yTarget));
-    kreature->body.color = Green;
-    kreature->body.offset = 0;
-    kreature->head.color = Green;
-    kreature->head.offset = 0;
-    kreature->limbs.color = Green;
-    kreature->limbs.offset = 0;
-    kreature->tail.color = Green;
-    kreature->tail.offset = 0;
+    std::size_t index = getIndex(spawnKreature(gf::Vector2f(x, y), rotation, gf::Vector2f(xTarget, yTarget)));
 
-    kreature->timeElapsed = gf::seconds(0.0f + gRandom().computeUniformFloat(0.01f, AnimationDuration.asSeconds() - 0.01f));
-    kreature->lifeCountdown = gf::seconds(std::numeric_limits<float>::max());
+    m_genomes[index] = KrokodileGenome;
 
-    m_kreatures.push_back(std::move(kreature));
+    // the krokodile never dies of old age
   }
 
   void KreatureContainer::resetKreatures() {
-    m_kreatures.clear();
-    for (int i = 0; i < SpawnLimit; ++i) {
+    m_handles.clear();
+    m_positions.clear();
+    m_orientations.clear();
+    m_movements.clear();
+    m_animationOrigins.clear();
+    m_lifeEnds.clear();
+    m_randoms.clear();
+    m_genomes.clear();
+    m_ageLevels.clear();
+    m_foodLevels.clear();
+    m_pool.clear();
+    m_grid.clear();
+    m_events.clear();
+    m_dyingHandles.clear();
+    m_player = HandlePool::InvalidHandle;
+
+    for (std::size_t i = 0; i < m_spawnLimit; ++i) {
       // Get the initial value
       float x = gRandom().computeUniformFloat(MinBound, MaxBound);
       float y = gRandom().computeUniformFloat(MinBound, MaxBound);
@@ -237,90 +368,77 @@ namespace kkd {
 
       float rotation = gRandom().computeUniformFloat(0.0f, 2 * gf::Pi);
 
-      auto kreature = std::make_unique<Kreature>(gf::Vector2f(x, y), rotation, gf::Vector2f(xTarget, yTarget));
-      kreature->body.color = randomColor();
-      kreature->body.offset = randomOffset();
-      kreature->head.color = randomColor();
-      kreature->head.offset = randomOffset();
-      kreature->limbs.color = randomColor();
-      kreature->limbs.offset = randomOffset();
-      kreature->tail.color = randomColor();
-      kreature->tail.offset = randomOffset();
-      kreature->timeElapsed = gf::seconds(0.0f + gRandom().computeUniformFloat(0.01f, AnimationDuration.asSeconds() - 0.01f));
-      kreature->lifeCountdown = gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime));
-
-      m_kreatures.push_back(std::move(kreature));
+      Handle handle = spawnKreature(gf::Vector2f(x, y), rotation, gf::Vector2f(xTarget, yTarget));
+      m_genomes[getIndex(handle)] = randomGenome();
+      setLifeTime(handle, gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime)));
     }
-  }
 
-  void KreatureContainer::resetActivities(Kreature& kreature) {
-    float xTarget = gRandom().computeUniformFloat(MinBound, MaxBound);
-    float yTarget = gRandom().computeUniformFloat(MinBound, MaxBound);
-    gf::Vector2f target = { xTarget, yTarget };
-
-    // Reset the activities
-    kreature.rotationActivity.setOrigin(kreature.orientation);
-    kreature.rotationActivity.setTarget(gf::angle(target - kreature.position));
-
-    kreature.moveActivity.setOrigin(kreature.position);
-    kreature.moveActivity.setTarget(target);
-    kreature.moveActivity.setDuration(gf::seconds(gf::euclideanDistance(kreature.position, target) / (ForwardVelocity * AiMalusVelocity)));
-
-    kreature.moveSequence.restart();
+    setPlayer(m_handles.front());
   }
 
   void KreatureContainer::update(gf::Time time) {
-    assert(!m_kreatures.empty());
+    assert(!m_handles.empty());
+    AllocationTracker::Scope allocationScope(Subsystem::Kreatures);
+    FrameProfiler::Zone zone("KreatureContainer::update");
+
+    ++m_tick;
+    m_clock += time;
+    m_lastStep = time;
 
     // Update the player
-    Kreature& player = getPlayer();
+    std::size_t playerIndex = getPlayerIndex();
 
-    // If we move
-    if (player.sideMove != 0 || player.forwardMove != 0) {
-      player.timeElapsed += time;
-    }
+    // keep the last state for the interpolation, the other kreatures are
+    // evaluated at the rendering time
+    m_previousPlayerPosition = m_positions[playerIndex];
+    m_previousPlayerOrientation = m_orientations[playerIndex];
 
-    if (player.timeElapsed >= AnimationDuration) {
-      player.timeElapsed -= AnimationDuration;
-      player.toggleAnimation = !player.toggleAnimation;
+    // The legs stop when we do not move
+    if (m_sideMove == 0 && m_forwardMove == 0) {
+      m_animationOrigins[playerIndex] += time;
     }
 
     // Update the orientation
-    player.orientation += SideVelocity * player.sideMove * time.asSeconds();
-    player.orientation = std::remainder(player.orientation, 2 * gf::Pi);
-    player.sideMove = 0;
+    float& orientation = m_orientations[playerIndex];
+    orientation += SideVelocity * m_sideMove * time.asSeconds();
+    orientation = std::remainder(orientation, 2 * gf::Pi);
 
     // Update the position
     float sprintFactor = 1.0f;
     if (m_isSprinting) {
       sprintFactor = SprintVeloctiy;
     }
-    player.position += gf::unit(player.orientation) * ForwardVelocity * player.forwardMove * time.asSeconds() * sprintFactor;
-    player.forwardMove = 0;
+    gf::Vector2f& position = m_positions[playerIndex];
+    position += gf::unit(orientation) * ForwardVelocity * m_forwardMove * time.asSeconds() * sprintFactor;
 
-    player.position = gf::clamp(player.position, MinBound, MaxBound);
+    position = gf::clamp(position, MinBound, MaxBound);
+    m_grid.update(HandlePool::getSlot(m_player), position);
 
-    // Update AI
-    for (unsigned i = 1; i < m_kreatures.size(); ++i) {
-      gf::ActivityStatus status = m_kreatures[i]->moveSequence.run(time);
+    // Waypoints and deaths that happened during this step
+    processEvents();
 
-      if (status == gf::ActivityStatus::Finished) {
-        resetActivities(*m_kreatures[i]);
-      }
+    // Update AI, a kreature only touches its own data so batches run in parallel
+    auto updateBatch = [this, playerIndex](std::size_t begin, std::size_t end) {
+      FrameProfiler::Zone zone("KreatureContainer::ai");
+
+      for (std::size_t i = begin; i < end; ++i) {
+        if (i == playerIndex) {
+          continue;
+        }
 
-      m_kreatures[i]->timeElapsed += time;
-      if (m_kreatures[i]->timeElapsed >= AnimationDuration) {
-        m_kreatures[i]->timeElapsed -= AnimationDuration;
-        m_kreatures[i]->toggleAnimation = !m_kreatures[i]->toggleAnimation;
+        m_positions[i] = m_movements[i].getPosition(m_clock);
+        m_orientations[i] = m_movements[i].getOrientation(m_clock);
       }
+    };
 
-      m_kreatures[i]->lifeCountdown -= time;
-    }
+    gWorkerPool().parallelFor(m_handles.size(), AiBatchSize, updateBatch);
 
-    KrokodilePosition message;
-    message.position = player.position;
-    message.angle = player.orientation;
-    gMessageManager().sendMessage(&message);
+    // the grid is shared, update it afterwards
+    for (std::size_t i = 0; i < m_handles.size(); ++i) {
+      if (i != playerIndex) {
+        m_grid.update(HandlePool::getSlot(m_handles[i]), m_positions[i]);
+      }
+    }
 
     // Update the food level
     float foodFactor = 1.0f;
@@ -331,23 +449,22 @@ namespace kkd {
 
     // Send stats to HUD
     KrokodileStats stats;
-    stats.foodLevel = player.foodLevel;
-    stats.ageLevel = player.ageLevel;
-    gMessageManager().sendMessage(&stats);
+    stats.foodLevel = m_foodLevels[playerIndex];
+    stats.ageLevel = m_ageLevels[playerIndex];
+    gMessageBus().post(stats);
 
     removeDeadKreature();
 
     // Repop if needed
-    while (m_kreatures.size() < MinimumPopulation) {
+    std::size_t missing = m_minimumPopulation - std::min(m_handles.size(), m_minimumPopulation);
+    std::size_t count = m_spawner.schedule(missing);
+
+    for (std::size_t i = 0; i < count; ++i) {
       // Get the initial value
-      float x = gRandom().computeUniformFloat(MinBound, MaxBound);
-      float y = gRandom().computeUniformFloat(MinBound, MaxBound);
-      gf::RectF viewBox({ gf::Vector2f(x, y) - 0.5f * gf::Vector2f(400.0f, 400.0f) }, { 400.0f, 400.0f });
+      gf::Vector2f position;
 
-      while (m_viewRect.intersects(viewBox)) {
-        x = gRandom().computeUniformFloat(MinBound, MaxBound);
-        y = gRandom().computeUniformFloat(MinBound, MaxBound);
-        viewBox.setPosition({ gf::Vector2f(x, y) - 0.5f * gf::Vector2f(400.0f, 400.0f) });
+      if (!m_spawner.computePosition(gRandom(), position)) {
+        break;
       }
 
       float xTarget = gRandom().computeUniformFloat(MinBound, MaxBound);
@@ -355,224 +472,490 @@ namespace kkd {
 
       float rotation = gRandom().computeUniformFloat(0.0f, 2 * gf::Pi);
 
-      auto kreature = std::make_unique<Kreature>(gf::Vector2f(x, y), rotation, gf::Vector2f(xTarget, yTarget));
-      kreature->body.color = randomColor();
-      kreature->body.offset = randomOffset();
-      kreature->head.color = randomColor();
-      kreature->head.offset = randomOffset();
-      kreature->limbs.color = randomColor();
-      kreature->limbs.offset = randomOffset();
-      kreature->tail.color = randomColor();
-      kreature->tail.offset = randomOffset();
-      kreature->timeElapsed = gf::seconds(0.0f + gRandom().computeUniformFloat(0.01f, AnimationDuration.asSeconds() - 0.01f));
-      kreature->lifeCountdown = gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime));
-
-      m_kreatures.push_back(std::move(kreature));
+      Handle handle = spawnKreature(position, rotation, gf::Vector2f(xTarget, yTarget));
+      m_genomes[getIndex(handle)] = randomGenome();
+      setLifeTime(handle, gf::seconds(gRandom().computeUniformFloat(MinimumLifeTime, MaximumLifeTime)));
     }
   }
 
   void KreatureContainer::render(gf::RenderTarget &target, const gf::RenderStates &states) {
-    for (unsigned i = 0; i < m_kreatures.size(); ++i) {
-      auto &kreature = m_kreatures[i];
-
-      static constexpr gf::Vector2f BodySpriteSize = { 256.0f, 256.0f };
-      static constexpr gf::Vector2f BodyWorldSize = { 128.0f, 128.0f };
+    AllocationTracker::Scope allocationScope(Subsystem::Kreatures);
+    FrameProfiler::Zone zone("KreatureContainer::render");
+
+    // normalized anchors
+    static constexpr gf::Vector2f CenterAnchor = { 0.5f, 0.5f };
+    static constexpr gf::Vector2f CenterLeftAnchor = { 0.0f, 0.5f };
+    static constexpr gf::Vector2f CenterRightAnchor = { 1.0f, 0.5f };
+    static constexpr gf::Vector2f BottomCenterAnchor = { 0.5f, 1.0f };
+
+    static constexpr std::size_t VerticesPerQuad = 6;
+    static constexpr std::size_t QuadsPerKreature = 7;
+
+    const gf::Vector2f bodyScale = BodyWorldSize / BodySpriteSize;
+    const gf::Vector2f headScale = HeadWorldSize / HeadSpriteSize;
+    const gf::Vector2f anteLegScale = AnteLegWorldSize / AnteLegSpriteSize;
+    const gf::Vector2f postLegScale = PostLegWorldSize / PostLegSpriteSize;
+    const gf::Vector2f tailScale = TailWorldSize / TailSpriteSize;
+
+    const gf::RectF headStrip = getAtlasRect(AtlasRegion::KreatureHead);
+    const gf::RectF anteLegStrip = getAtlasRect(AtlasRegion::KreatureAnteLeg);
+    const gf::RectF postLegStrip = getAtlasRect(AtlasRegion::KreaturePostLeg);
+    const gf::RectF tailStrip = getAtlasRect(AtlasRegion::KreatureTail);
+    const gf::RectF bodyStrip = getAtlasRect(AtlasRegion::KreatureBody);
+
+    const gf::Vector2f animalScale = { 1.0f / AnimalCount, 1.0f };
+
+    const auto& palette = getPalette();
+    const gf::Vector2f headSize = getAtlasSize(AtlasRegion::KreatureHead) * animalScale;
+    const gf::Vector2f anteLegSize = getAtlasSize(AtlasRegion::KreatureAnteLeg) * animalScale;
+    const gf::Vector2f postLegSize = getAtlasSize(AtlasRegion::KreaturePostLeg) * animalScale;
+    const gf::Vector2f tailSize = getAtlasSize(AtlasRegion::KreatureTail) * animalScale;
+    const gf::Vector2f bodySize = getAtlasSize(AtlasRegion::KreatureBody) * animalScale;
+
+    // only the kreatures that may overlap the view
+    gf::RectF cullingRect(
+      gf::Vector2f(m_viewRect.left - m_cullingPadding, m_viewRect.top - m_cullingPadding),
+      gf::Vector2f(m_viewRect.width + 2 * m_cullingPadding, m_viewRect.height + 2 * m_cullingPadding)
+    );
+
+    m_visibleSlots.clear();
+    m_grid.queryRect(cullingRect, [this](std::size_t slot, gf::Vector2f position) {
+      (void) position;
+      m_visibleSlots.push_back(slot);
+    });
 
-      gf::Sprite body(m_kreatureBodyTexture, gf::RectF(kreature->body.offset * gf::Vector2f(1.0f / TotalAnimal, 0.0f), { 1.0f / TotalAnimal, 1.0f }));
-      body.setScale(BodyWorldSize / BodySpriteSize);
-      body.setColor(getKreatureColor(kreature->body.color));
-      body.setPosition(kreature->position);
-      body.setRotation(kreature->orientation);
+    // a kreature keeps its slot, it keeps the drawing order stable
+    std::sort(m_visibleSlots.begin(), m_visibleSlots.end());
+
+    m_visibleCount = m_visibleSlots.size();
+    m_culledCount = m_handles.size() - m_visibleCount;
+
+    // the rendering is between the last two updates
+    const gf::Time renderTime = m_clock - m_lastStep * (1.0f - m_interpolation);
+    const std::size_t playerIndex = getPlayerIndex();
+
+    // all the limbs first, then all the bodies, so that bodies are printed over
+    const std::size_t count = m_visibleSlots.size();
+    m_vertices.resize(count * QuadsPerKreature * VerticesPerQuad);
+
+    gf::Vertex *limbQuads = m_vertices.data();
+    gf::Vertex *bodyQuads = m_vertices.data() + count * (QuadsPerKreature - 1) * VerticesPerQuad;
+
+    for (auto slot : m_visibleSlots) {
+      std::size_t i = getIndex(m_pool.getHandle(slot));
+      const Genome genome = m_genomes[i];
+      const Gene head = getGene(genome, GenomePart::Head);
+      const Gene body = getGene(genome, GenomePart::Body);
+      const Gene limbs = getGene(genome, GenomePart::Limbs);
+      const Gene tail = getGene(genome, GenomePart::Tail);
+      const auto& joints = m_cropBoxes[getGeneOffset(body)];
+
+      gf::Vector2f position;
+      float orientation;
+
+      if (i == playerIndex) {
+        position = gf::lerp(m_previousPlayerPosition, m_positions[i], m_interpolation);
+        orientation = interpolateAngle(m_previousPlayerOrientation, m_orientations[i], m_interpolation);
+      } else {
+        position = m_movements[i].getPosition(renderTime);
+        orientation = m_movements[i].getOrientation(renderTime);
+      }
 
-      gf::Matrix3f bodyMatrix = body.getTransform();
+      float cos = std::cos(orientation);
+      float sin = std::sin(orientation);
 
-      body.setAnchor(gf::Anchor::Center);
+      auto jointPosition = [&](gf::Vector2f joint) {
+        joint = bodyScale * joint;
+        return position + gf::Vector2f(cos * joint.x - sin * joint.y, sin * joint.x + cos * joint.y);
+      };
 
       float animationRotationOffset = 0.0f;
 
-      if (kreature->toggleAnimation) {
+      if (isAnimationToggled(i)) {
         animationRotationOffset = gf::Pi / 8.0f * -1.0f;
       }
       else {
         animationRotationOffset = gf::Pi / 8.0f * +1.0f;
       }
 
-      static constexpr gf::Vector2f HeadSpriteSize = { 256.0f, 256.0f };
-      static constexpr gf::Vector2f HeadWorldSize = { 128.0f, 128.0f };
-      // Not work !
-      // static constexpr gf::Vector2f HeadScale = HeadWorldSize / HeadSpriteSize;
+      gf::Color4f limbsColor = palette[getGeneColor(limbs)];
 
-      gf::Sprite head(m_kreatureHeadTexture, gf::RectF(kreature->head.offset * gf::Vector2f(1.0f / TotalAnimal, 0.0f), { 1.0f / TotalAnimal, 1.0f }));
-      head.setScale(HeadWorldSize.x / HeadSpriteSize);
-      head.setAnchor(gf::Anchor::CenterLeft);
-      head.setColor(getKreatureColor(kreature->head.color));
-      head.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][0]));
-      head.setRotation(kreature->orientation);
-      head.draw(target, states);
+      writePartQuad(limbQuads, headStrip, headSize, getGeneOffset(head), palette[getGeneColor(head)], CenterLeftAnchor, headScale, jointPosition(joints[0]), orientation);
+      limbQuads += VerticesPerQuad;
 
-      static constexpr gf::Vector2f AnteLegSpriteSize = { 128.0f, 128.0f };
-      static constexpr gf::Vector2f AnteLegWorldSize = { 64.0f, 64.0f };
+      writePartQuad(limbQuads, anteLegStrip, anteLegSize, getGeneOffset(limbs), limbsColor, BottomCenterAnchor, anteLegScale, jointPosition(joints[1]), orientation + animationRotationOffset);
+      limbQuads += VerticesPerQuad;
+      writePartQuad(limbQuads, anteLegStrip, anteLegSize, getGeneOffset(limbs), limbsColor, BottomCenterAnchor, anteLegScale * gf::Vector2f(1.0f, -1.0f), jointPosition(joints[2]), orientation + animationRotationOffset);
+      limbQuads += VerticesPerQuad;
 
-      gf::Sprite anteLeg(m_kreatureAnteLegTexture, gf::RectF(kreature->limbs.offset * gf::Vector2f(1.0f / TotalAnimal, 0.0f), { 1.0f / TotalAnimal, 1.0f }));
-      anteLeg.setScale(AnteLegWorldSize / AnteLegSpriteSize);
-      anteLeg.setAnchor(gf::Anchor::BottomCenter);
-      anteLeg.setColor(getKreatureColor(kreature->limbs.color));
-      anteLeg.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][1]));
-      anteLeg.setRotation(kreature->orientation + animationRotationOffset);
-      anteLeg.draw(target, states);
-      anteLeg.scale({ 1.0f, -1.0f });
-      anteLeg.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][2]));
-      anteLeg.draw(target, states);
+      writePartQuad(limbQuads, postLegStrip, postLegSize, getGeneOffset(limbs), limbsColor, BottomCenterAnchor, postLegScale, jointPosition(joints[3]), orientation + animationRotationOffset);
+      limbQuads += VerticesPerQuad;
+      writePartQuad(limbQuads, postLegStrip, postLegSize, getGeneOffset(limbs), limbsColor, BottomCenterAnchor, postLegScale * gf::Vector2f(1.0f, -1.0f), jointPosition(joints[4]), orientation + animationRotationOffset);
+      limbQuads += VerticesPerQuad;
 
-      static constexpr gf::Vector2f PostLegSpriteSize = { 128.0f, 128.0f };
-      static constexpr gf::Vector2f PostLegWorldSize = { 64.0f, 64.0f };
+      writePartQuad(limbQuads, tailStrip, tailSize, getGeneOffset(tail), palette[getGeneColor(tail)], CenterRightAnchor, tailScale, jointPosition(joints[5]), orientation);
+      limbQuads += VerticesPerQuad;
 
-      gf::Sprite postLeg(m_kreaturePostLegTexture, gf::RectF(kreature->limbs.offset * gf::Vector2f(1.0f / TotalAnimal, 0.0f), { 1.0f / TotalAnimal, 1.0f }));
-      postLeg.setScale(PostLegWorldSize / PostLegSpriteSize);
-      postLeg.setAnchor(gf::Anchor::BottomCenter);
-      postLeg.setColor(getKreatureColor(kreature->limbs.color));
-      postLeg.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][3]));
-      postLeg.setRotation(kreature->orientation + animationRotationOffset);
-      postLeg.draw(target, states);
-      postLeg.setScale({ PostLegWorldSize.x / PostLegSpriteSize.x, -PostLegWorldSize.y / PostLegSpriteSize.y });
-      postLeg.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][4]));
-      postLeg.draw(target, states);
+      writePartQuad(bodyQuads, bodyStrip, bodySize, getGeneOffset(body), palette[getGeneColor(body)], CenterAnchor, bodyScale, position, orientation);
+      bodyQuads += VerticesPerQuad;
+    }
 
-      static constexpr gf::Vector2f TailSpriteSize = { 256.0f, 256.0f };
-      static constexpr gf::Vector2f TailWorldSize = { 128.0f, 128.0f };
+    m_drawCalls = 0;
 
-      gf::Sprite tail(m_kreatureTailTexture, gf::RectF(kreature->tail.offset * gf::Vector2f(1.0f / TotalAnimal, 0.0f), { 1.0f / TotalAnimal, 1.0f }));
-      tail.setScale(TailWorldSize / TailSpriteSize);
-      tail.setAnchor(gf::Anchor::CenterRight);
-      tail.setColor(getKreatureColor(kreature->tail.color));
-      tail.setPosition(gf::transform(bodyMatrix, m_cropBoxes[kreature->body.offset][5]));
-      tail.setRotation(kreature->orientation);
-      tail.draw(target, states);
+    if (m_vertices.empty()) {
+      return;
+    }
 
-      // to print over
-      body.draw(target, states);
+    if (m_atlasTexture == nullptr) {
+      m_atlasTexture = &getAtlasTexture();
     }
+
+    gf::RenderStates localStates = states;
+    localStates.texture = m_atlasTexture;
+    target.draw(m_vertices.data(), m_vertices.size(), gf::PrimitiveType::Triangles, localStates);
+    ++m_drawCalls;
   }
 
-  gf::MessageStatus KreatureContainer::onSizeView(gf::Id id, gf::Message *msg) {
-    assert(id == ViewSize::type);
-    ViewSize *viewSize = static_cast<ViewSize*>(msg);
+  void KreatureContainer::setInterpolation(float alpha) {
+    m_interpolation = gf::clamp(alpha, 0.0f, 1.0f);
 
-    m_viewRect = gf::RectF(viewSize->viewCenter - 0.5f * viewSize->viewSize - gf::Vector2f(25.0f, 25.0f), viewSize->viewSize + 2 * gf::Vector2f(25.0f, 25.0f));
+    std::size_t playerIndex = getPlayerIndex();
 
-    return gf::MessageStatus::Keep;
+    KrokodilePosition message;
+    message.position = gf::lerp(m_previousPlayerPosition, m_positions[playerIndex], m_interpolation);
+    message.angle = interpolateAngle(m_previousPlayerOrientation, m_orientations[playerIndex], m_interpolation);
+    gMessageBus().post(message);
   }
 
-  std::unique_ptr<KreatureContainer::Kreature>& KreatureContainer::getPlayerPtr() {
-    assert(!m_kreatures.empty());
-    return m_kreatures.front();
+  std::size_t KreatureContainer::getDrawCallCount() const {
+    return m_drawCalls;
   }
 
-  KreatureContainer::Kreature& KreatureContainer::getPlayer() {
-    assert(!m_kreatures.empty());
-    return *m_kreatures.front();
+  std::size_t KreatureContainer::getVertexCount() const {
+    return m_vertices.size();
   }
 
-  const KreatureContainer::Kreature& KreatureContainer::getPlayer() const {
-    assert(!m_kreatures.empty());
-    return *m_kreatures.front();
+  std::size_t KreatureContainer::getVisibleCount() const {
+    return m_visibleCount;
   }
 
-  std::unique_ptr<KreatureContainer::Kreature>& KreatureContainer::getCloserKreature() {
-    auto newKreature = std::min_element(m_kreatures.begin() + 1, m_kreatures.end(), [this](auto &krea1, auto &krea2){
-      float length1 = gf::euclideanDistance(m_kreatures[0]->position, krea1->position);
-      float length2 = gf::euclideanDistance(m_kreatures[0]->position, krea2->position);
-      return length1 < length2;
-    });
+  std::size_t KreatureContainer::getCulledCount() const {
+    return m_culledCount;
+  }
 
-    return *newKreature;
+  std::size_t KreatureContainer::getSpawnQueueDepth() const {
+    return m_spawner.getQueueDepth();
   }
 
-  int KreatureContainer::colorCompare(ColorName color1, ColorName color2) {
-    switch (color1) {
-      case Azure:
-        if (color2 == Yellow || color2 == Magenta) {
-          return 1;
-        }
-        if (color2 == Green || color2 == Red) {
-          return -1;
-        }
-        return 0;
+  std::size_t KreatureContainer::getPopulation() const {
+    return m_handles.size();
+  }
 
-      case Green:
-        if (color2 == Azure || color2 == Yellow) {
-          return 1;
-        }
-        if (color2 == Magenta || color2 == Red) {
-          return -1;
-        }
-        return 0;
+  uint64_t KreatureContainer::getSpawnCount() const {
+    return m_spawnCount;
+  }
 
-      case Yellow:
-        if (color2 == Red || color2 == Magenta) {
-          return 1;
-        }
-        if (color2 == Azure || color2 == Green) {
-          return -1;
-        }
-        return 0;
+  uint64_t KreatureContainer::getDespawnCount() const {
+    return m_despawnCount;
+  }
 
-      case Red:
-        if (color2 == Azure || color2 == Green) {
-          return 1;
-        }
-        if (color2 == Yellow || color2 == Magenta) {
-          return -1;
-        }
-        return 0;
+  uint64_t KreatureContainer::computeStateHash() const {
+    uint64_t hash = UINT64_C(0xCBF29CE484222325);
 
-      case Magenta:
-        if (color2 == Red || color2 == Green) {
-          return 1;
-        }
-        if (color2 == Yellow || color2 == Azure) {
-          return -1;
-        }
-        return 0;
+    auto combine = [&hash](const void *data, std::size_t size) {
+      auto bytes = static_cast<const unsigned char *>(data);
 
-      default:
-        assert(false);
-        break;
+      for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * UINT64_C(0x100000001B3);
+      }
+    };
+
+    combine(&m_tick, sizeof(m_tick));
+    combine(&m_player, sizeof(m_player));
+
+    for (std::size_t i = 0; i < m_handles.size(); ++i) {
+      combine(&m_handles[i], sizeof(Handle));
+      combine(&m_positions[i].x, sizeof(float));
+      combine(&m_positions[i].y, sizeof(float));
+      combine(&m_orientations[i], sizeof(float));
+      combine(&m_genomes[i], sizeof(Genome));
+      combine(&m_ageLevels[i], sizeof(int));
+      combine(&m_foodLevels[i], sizeof(float));
     }
 
-    return 0;
+    return hash;
   }
 
-  KreatureContainer::Part KreatureContainer::fusionPart(KreatureContainer::Part currentPart, KreatureContainer::Part otherPart) {
-    Part newPart = currentPart;
+  void KreatureContainer::writeSnapshot(std::FILE *file) const {
+    std::fprintf(file, "tick %llu, time %.3f s, population %zu, dying %zu, spawn queue %zu, player %llu\n",
+      static_cast<unsigned long long>(m_tick), m_clock.asSeconds(), m_handles.size(), m_dyingHandles.size(), m_spawner.getQueueDepth(), static_cast<unsigned long long>(m_player));
+    std::fprintf(file, "handle x y orientation target_x target_y age food genome\n");
 
-    float fusionFactor = 0.0f;
-    if (colorCompare(currentPart.color, otherPart.color) == 1) {
-      fusionFactor = UpperFusionFactor;
+    for (std::size_t i = 0; i < m_handles.size(); ++i) {
+      std::fprintf(file, "%llu %.1f %.1f %.3f %.1f %.1f %d %.1f %04x\n",
+        static_cast<unsigned long long>(m_handles[i]), m_positions[i].x, m_positions[i].y, m_orientations[i],
+        m_movements[i].target.x, m_movements[i].target.y, m_ageLevels[i], m_foodLevels[i], static_cast<unsigned>(m_genomes[i]));
     }
-    else {
-      fusionFactor = LowerFusionFactor;
+  }
+
+  void KreatureContainer::onSizeView(const ViewSize& message) {
+    m_viewRect = gf::RectF(message.viewCenter - 0.5f * message.viewSize - gf::Vector2f(25.0f, 25.0f), message.viewSize + 2 * gf::Vector2f(25.0f, 25.0f));
+
+    // a new kreature must not pop up in the view
+    m_spawner.setExclusion(gf::RectF(
+      gf::Vector2f(m_viewRect.left - SpawnDistance, m_viewRect.top - SpawnDistance),
+      gf::Vector2f(m_viewRect.width + 2 * SpawnDistance, m_viewRect.height + 2 * SpawnDistance)
+    ));
+  }
+
+  void KreatureContainer::reserveKreatures(std::size_t capacity) {
+    m_pool.reserve(capacity);
+    m_grid.reserve(capacity);
+    m_handles.reserve(capacity);
+    m_positions.reserve(capacity);
+    m_orientations.reserve(capacity);
+    m_movements.reserve(capacity);
+    m_animationOrigins.reserve(capacity);
+    m_lifeEnds.reserve(capacity);
+    m_randoms.reserve(capacity);
+    m_genomes.reserve(capacity);
+    m_ageLevels.reserve(capacity);
+    m_foodLevels.reserve(capacity);
+    m_dyingHandles.reserve(capacity);
+    m_visibleSlots.reserve(capacity);
+  }
+
+  KreatureContainer::Handle KreatureContainer::spawnKreature(gf::Vector2f position, float rotation, gf::Vector2f target) {
+    Handle handle = m_pool.allocate(m_handles.size());
+    m_handles.push_back(handle);
+
+    m_positions.push_back(position);
+    m_orientations.push_back(rotation);
+    m_movements.push_back(createMovement(position, rotation, target, m_clock));
+    m_events.push(m_movements.back().getEndTime(), EventQueue::Type::WaypointReached, handle);
+
+    // random phase, so that the kreatures do not walk in step
+    m_animationOrigins.push_back(m_clock - gf::seconds(gRandom().computeUniformFloat(0.01f, AnimationDuration.asSeconds() - 0.01f)));
+
+    m_lifeEnds.push_back(NoLifeEnd);
+    m_randoms.push_back(RandomStream(m_seed, handle, m_tick));
+    m_genomes.push_back(0);
+    m_ageLevels.push_back(static_cast<int>(MaxAge));
+    m_foodLevels.push_back(0.0f);
+
+    m_grid.insert(HandlePool::getSlot(handle), position);
+    ++m_spawnCount;
+
+    return handle;
+  }
+
+  void KreatureContainer::despawnKreature(std::size_t index) {
+    assert(index < m_handles.size());
+    std::size_t last = m_handles.size() - 1;
+
+    m_grid.remove(HandlePool::getSlot(m_handles[index]));
+    m_pool.release(m_handles[index]);
+
+    if (index != last) {
+      m_handles[index] = m_handles[last];
+      m_positions[index] = m_positions[last];
+      m_orientations[index] = m_orientations[last];
+      m_movements[index] = m_movements[last];
+      m_animationOrigins[index] = m_animationOrigins[last];
+      m_lifeEnds[index] = m_lifeEnds[last];
+      m_randoms[index] = m_randoms[last];
+      m_genomes[index] = m_genomes[last];
+      m_ageLevels[index] = m_ageLevels[last];
+      m_foodLevels[index] = m_foodLevels[last];
+
+      m_pool.setIndex(m_handles[index], index);
     }
 
+    m_handles.pop_back();
+    m_positions.pop_back();
+    m_orientations.pop_back();
+    m_movements.pop_back();
+    m_animationOrigins.pop_back();
+    m_lifeEnds.pop_back();
+    m_randoms.pop_back();
+    m_genomes.pop_back();
+    m_ageLevels.pop_back();
+    m_foodLevels.pop_back();
+    ++m_despawnCount;
+  }
+
+  gf::Time KreatureContainer::Movement::getEndTime() const {
+    return start + RotationDuration + moveDuration;
+  }
+
+  gf::Vector2f KreatureContainer::Movement::getPosition(gf::Time time) const {
+    gf::Time walkStart = start + RotationDuration;
+
+    if (time <= walkStart) {
+      return origin;
+    }
+
+    if (time >= walkStart + moveDuration) {
+      return target;
+    }
+
+    float t = (time - walkStart).asSeconds() / moveDuration.asSeconds();
+    return gf::lerp(origin, target, t);
+  }
+
+  float KreatureContainer::Movement::getOrientation(gf::Time time) const {
+    float t = gf::clamp((time - start).asSeconds() / RotationDuration.asSeconds(), 0.0f, 1.0f);
+    return originAngle + t * deltaAngle;
+  }
+
+  KreatureContainer::Movement KreatureContainer::createMovement(gf::Vector2f origin, float angle, gf::Vector2f target, gf::Time start) {
+    // take the shortest way
+    float originAngle = std::remainder(angle, 2 * gf::Pi);
+    float targetAngle = std::remainder(gf::angle(target - origin), 2 * gf::Pi);
+
+    Movement movement;
+    movement.origin = origin;
+    movement.target = target;
+    movement.originAngle = originAngle;
+    movement.deltaAngle = std::remainder(targetAngle - originAngle, 2 * gf::Pi);
+    movement.start = start;
+    movement.moveDuration = gf::seconds(gf::euclideanDistance(origin, target) / (ForwardVelocity * AiMalusVelocity));
+    return movement;
+  }
+
+  void KreatureContainer::startMovement(std::size_t index, gf::Time start) {
+    float xTarget = m_randoms[index].computeUniformFloat(MinBound, MaxBound);
+    float yTarget = m_randoms[index].computeUniformFloat(MinBound, MaxBound);
+
+    m_movements[index] = createMovement(m_positions[index], m_orientations[index], { xTarget, yTarget }, start);
+    m_events.push(m_movements[index].getEndTime(), EventQueue::Type::WaypointReached, m_handles[index]);
+  }
+
+  void KreatureContainer::setLifeTime(Handle handle, gf::Time lifeTime) {
+    gf::Time lifeEnd = m_clock + lifeTime;
+    m_lifeEnds[getIndex(handle)] = lifeEnd;
+    m_events.push(lifeEnd, EventQueue::Type::LifeExpired, handle);
+  }
+
+  void KreatureContainer::processEvents() {
+    while (m_events.hasEventBefore(m_clock)) {
+      EventQueue::Event event = m_events.pop();
+
+      // the kreature has been removed since
+      if (!m_pool.isValid(event.id)) {
+        continue;
+      }
+
+      switch (event.type) {
+        case EventQueue::Type::LifeExpired:
+          // the life of the player is paused, a swap schedules a new end
+          if (event.id == m_player || m_lifeEnds[getIndex(event.id)] != event.time) {
+            break;
+          }
+
+          m_dyingHandles.push_back(event.id);
+          break;
+
+        case EventQueue::Type::WaypointReached: {
+          std::size_t index = getIndex(event.id);
+          const Movement& movement = m_movements[index];
+
+          // the player walks on its own, and a swap restarts the movement
+          if (event.id == m_player || movement.getEndTime() != event.time) {
+            break;
+          }
+
+          // the next waypoint starts exactly where the last one stopped
+          m_positions[index] = movement.target;
+          m_orientations[index] = movement.getOrientation(event.time);
+          startMovement(index, event.time);
+          break;
+        }
+      }
+    }
+  }
+
+  bool KreatureContainer::isAnimationToggled(std::size_t index) const {
+    int64_t periods = (m_clock - m_animationOrigins[index]).asMicroseconds() / AnimationDuration.asMicroseconds();
+    return periods % 2 == 0;
+  }
+
+  void KreatureContainer::setPlayer(Handle handle) {
+    // the previous player ages again from where it stopped
+    if (m_pool.isValid(m_player) && m_player != handle && m_lifeEnds[getIndex(m_player)] != NoLifeEnd) {
+      setLifeTime(m_player, m_playerLife);
+    }
+
+    m_player = handle;
+
+    std::size_t index = getIndex(handle);
+    m_playerLife = m_lifeEnds[index] - m_clock;
+    m_previousPlayerPosition = m_positions[index];
+    m_previousPlayerOrientation = m_orientations[index];
+  }
+
+  std::size_t KreatureContainer::getIndex(Handle handle) const {
+    assert(m_pool.isValid(handle));
+    return m_pool.getIndex(handle);
+  }
+
+  std::size_t KreatureContainer::getPlayerIndex() const {
+    assert(!m_handles.empty());
+    return getIndex(m_player);
+  }
+
+  std::size_t KreatureContainer::getCloserKreature() const {
+    std::size_t playerIndex = getPlayerIndex();
+    std::size_t closer = m_grid.queryNearest(m_positions[playerIndex], std::numeric_limits<float>::max(), HandlePool::getSlot(m_player));
+    assert(closer != SpatialGrid::InvalidId);
+    return getIndex(m_pool.getHandle(closer));
+  }
+
+  Gene KreatureContainer::fusionGene(Gene currentGene, Gene otherGene) {
+    int offset = getGeneOffset(currentGene);
+    ColorName color = getGeneColor(currentGene);
+    ColorName otherColor = getGeneColor(otherGene);
+
     float rand = gRandom().computeUniformFloat(0.0f, 1.0f);
     if (rand > 0.5) {
-      newPart.offset = otherPart.offset;
+      offset = getGeneOffset(otherGene);
     }
-    if (rand > fusionFactor) {
-      newPart.color = otherPart.color;
+    if (rand > FusionThresholds[color][otherColor]) {
+      color = otherColor;
     }
     else if (rand >= FumbleMutation) {
-      newPart.color = randomColor();
-      newPart.offset = randomOffset();
+      color = randomColor();
+      offset = randomOffset();
+    }
+
+    return makeGene(offset, color);
+  }
+
+  Genome KreatureContainer::fusionGenome(Genome currentGenome, Genome otherGenome) {
+    Genome genome = currentGenome;
+
+    for (auto part : { GenomePart::Body, GenomePart::Head, GenomePart::Tail, GenomePart::Limbs }) {
+      genome = setGene(genome, part, fusionGene(getGene(currentGenome, part), getGene(otherGenome, part)));
+    }
+
+    return genome;
+  }
+
+  Genome KreatureContainer::randomGenome() {
+    Genome genome = 0;
+
+    for (auto part : { GenomePart::Body, GenomePart::Head, GenomePart::Limbs, GenomePart::Tail }) {
+      ColorName color = randomColor();
+      genome = setGene(genome, part, makeGene(randomOffset(), color));
     }
 
-    return newPart;
+    return genome;
   }
 
   void KreatureContainer::addFoodLevel(float consumption) {
-    auto& player = getPlayer();
-    player.foodLevel += consumption;
-    player.foodLevel = gf::clamp(player.foodLevel, 0.0f, FoodLevelMax);
+    float& foodLevel = m_foodLevels[getPlayerIndex()];
+    foodLevel += consumption;
+    foodLevel = gf::clamp(foodLevel, 0.0f, FoodLevelMax);
   }
 
 }
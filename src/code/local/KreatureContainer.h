@@ -19,70 +19,53 @@
 #ifndef _KKD_KREATURE_CONTAINER_H
 #define _KKD_KREATURE_CONTAINER_H
 
-#include <memory>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <vector>
 
-#include <gf/Activities.h>
 #include <gf/Entity.h>
+#include <gf/Rect.h>
+#include <gf/Texture.h>
+#include <gf/Time.h>
 #include <gf/Vector.h>
 #include <gf/VectorOps.h>
+#include <gf/Vertex.h>
 
+#include "EventQueue.h"
+#include "Genome.h"
+#include "HandlePool.h"
+#include "Messages.h"
+#include "RandomStream.h"
 #include "Singletons.h"
+#include "SpatialGrid.h"
+#include "SpawnDirector.h"
 
 namespace kkd {
   class KreatureContainer : public gf::Entity {
-  public:
-    enum ColorName : int {
-      Azure = 0,
-      Green = 1,
-      Yellow = 2,
-      Red = 3,
-      Magenta = 4,
-    };
-
   private:
-    struct Part {
-      int offset = 0;
-      ColorName color;
-
-      bool canBeK() const {
-        return offset == 0 && color == Green;
-      }
-    };
-
-    struct Kreature {
-      Kreature(gf::Vector2f kreaPosition, float kreaRotation, gf::Vector2f kreaTarget)
-      : position(kreaPosition)
-      , orientation(kreaRotation)
-      , rotationActivity(kreaRotation, gf::angle(kreaTarget - kreaPosition), orientation, gf::seconds(activityRotationTime))
-      , moveActivity(kreaPosition, kreaTarget, position, gf::seconds(gf::euclideanDistance(kreaPosition, kreaTarget) / (ForwardVelocity * AiMalusVelocity))) {
-        moveSequence.addActivity(rotationActivity);
-        moveSequence.addActivity(moveActivity);
-      }
-
-      int ageLevel = MaxAge;
-      float foodLevel = 0.0f;
-
-      Part head;
-      Part body;
-      Part limbs;
-      Part tail;
-
-      gf::Vector2f position;
-      float orientation;
-      float forwardMove = 0; // 1 to forward / -1 to backward
-      float sideMove = 0; // 1 to rigth / -1 to left
-      gf::Time timeElapsed;
-      bool toggleAnimation = true;
-      gf::Time lifeCountdown;
-
-      gf::RotateToActivity rotationActivity;
-      gf::MoveToActivity moveActivity;
-      gf::SequenceActivity moveSequence;
+    using Handle = HandlePool::Handle;
+
+    // rotate toward the target, then walk to it, as a function of the
+    // simulation time
+    struct Movement {
+      gf::Vector2f origin;
+      gf::Vector2f target;
+      float originAngle;
+      float deltaAngle; // shortest way to the target angle
+      gf::Time start;
+      gf::Time moveDuration;
+
+      gf::Time getEndTime() const;
+      gf::Vector2f getPosition(gf::Time time) const;
+      float getOrientation(gf::Time time) const;
     };
 
   public:
-    explicit KreatureContainer();
+    // the minimum population is scaled with the initial population
+    explicit KreatureContainer(std::size_t population = SpawnLimit);
+    ~KreatureContainer();
 
     void playerForwardMove(int direction);
     void playerSidedMove(int direction);
@@ -96,12 +79,38 @@ namespace kkd {
 
     void resetKreatures();
 
-    void resetActivities(Kreature& kreature);
-
     virtual void update(gf::Time time) override;
     virtual void render(gf::RenderTarget &target, const gf::RenderStates &states) override;
 
-    gf::MessageStatus onSizeView(gf::Id id, gf::Message *msg);
+    // position of the rendering between the last two updates, from 0 to 1
+    void setInterpolation(float alpha);
+
+    void onSizeView(const ViewSize& message);
+
+    // number of draw calls issued by the last render
+    std::size_t getDrawCallCount() const;
+
+    // number of vertices submitted by the last render
+    std::size_t getVertexCount() const;
+
+    // number of kreatures drawn and skipped by the last render
+    std::size_t getVisibleCount() const;
+    std::size_t getCulledCount() const;
+
+    // kreatures waiting to be spawned
+    std::size_t getSpawnQueueDepth() const;
+
+    std::size_t getPopulation() const;
+
+    // kreatures spawned and despawned since the creation
+    uint64_t getSpawnCount() const;
+    uint64_t getDespawnCount() const;
+
+    // one line for the container, then one line per kreature
+    void writeSnapshot(std::FILE *file) const;
+
+    // FNV-1a of the simulation state, to compare two runs
+    uint64_t computeStateHash() const;
 
   private:
     static constexpr int MaxAge = 5;
@@ -111,43 +120,96 @@ namespace kkd {
     static constexpr float MaximumLifeTime = 90.0f;
     static constexpr float ForwardVelocity = 200.0f;
     static constexpr float SideVelocity = 2.0f;
-    static constexpr float activityRotationTime = 1.0f;
+    static constexpr gf::Time RotationDuration = gf::seconds(1.0f);
     static constexpr float AiMalusVelocity = 0.80f;
     static constexpr float FoodLevelMax = 100.0f;
     static constexpr float FoodLevelSteps = 15.0f;
     static constexpr float SprintVeloctiy = 2.0f;
     static constexpr float SprintFoodConsumption = -2.0f;
 
+    static constexpr std::size_t SpawnBudget = 8; // per tick, at least
+    static constexpr std::size_t SpawnBudgetRatio = 100; // one percent of the population per tick
+    static constexpr float SpawnDistance = 200.0f; // from the view
+
     static constexpr float MaxBound = 1500.0f;
     static constexpr float MinBound = - MaxBound;
 
     static constexpr float FusionFoodConsumption = 0.80f * FoodLevelMax;
-    static constexpr float UpperFusionFactor = 0.75f;
-    static constexpr float LowerFusionFactor = 0.25f;
-    static constexpr float FumbleMutation = 0.90f;
     static constexpr float LimitLengthFusion = 150.0f;
+    static constexpr float GridCellSize = LimitLengthFusion;
+    static constexpr std::size_t AiBatchSize = 512;
+    static constexpr std::size_t PoolCapacityFactor = 2; // room for the fusions above the spawn limit
     static constexpr gf::Time AnimationDuration = gf::seconds(0.25f);
 
   private:
-    std::unique_ptr<Kreature>& getPlayerPtr();
-    Kreature& getPlayer();
-    const Kreature& getPlayer() const;
-    std::unique_ptr<Kreature>& getCloserKreature();
-    int colorCompare(ColorName color1, ColorName color2);
-    Part fusionPart(Part currentPart, Part otherPart);
+    void reserveKreatures(std::size_t capacity);
+    Handle spawnKreature(gf::Vector2f position, float rotation, gf::Vector2f target);
+    void despawnKreature(std::size_t index);
+    static Movement createMovement(gf::Vector2f origin, float angle, gf::Vector2f target, gf::Time start);
+    void startMovement(std::size_t index, gf::Time start);
+    void setLifeTime(Handle handle, gf::Time lifeTime);
+    void processEvents();
+    bool isAnimationToggled(std::size_t index) const;
+    void setPlayer(Handle handle);
+
+    std::size_t getIndex(Handle handle) const;
+    std::size_t getPlayerIndex() const;
+    std::size_t getCloserKreature() const;
+    Gene fusionGene(Gene currentGene, Gene otherGene);
+    Genome fusionGenome(Genome currentGenome, Genome otherGenome);
+    Genome randomGenome();
     void addFoodLevel(float consumption);
 
   private:
-    std::vector< std::unique_ptr<Kreature> > m_kreatures;
-    gf::Texture& m_kreatureHeadTexture;
-    gf::Texture& m_kreaturePostLegTexture;
-    gf::Texture& m_kreatureAnteLegTexture;
-    gf::Texture& m_kreatureBodyTexture;
-    gf::Texture& m_kreatureTailTexture;
+    // Kreatures are stored as a structure of arrays sharing the same dense
+    // index. A kreature is addressed from outside through its handle, which
+    // stays valid when the dense index changes.
+    std::vector<Handle> m_handles;
+    std::vector<gf::Vector2f> m_positions;
+    std::vector<float> m_orientations;
+    std::vector<Movement> m_movements;
+    std::vector<gf::Time> m_animationOrigins; // the legs swing every AnimationDuration since then
+    std::vector<gf::Time> m_lifeEnds; // a LifeExpired event at another time is stale
+    std::vector<RandomStream> m_randoms;
+    std::vector<Genome> m_genomes;
+    std::vector<int> m_ageLevels;
+    std::vector<float> m_foodLevels;
+
+    HandlePool m_pool; // handle -> dense index
+    Handle m_player;
+    gf::Time m_playerLife; // the life left is paused while the kreature is the player
+    gf::Vector2f m_previousPlayerPosition;
+    float m_previousPlayerOrientation;
+
+    uint64_t m_seed;
+    uint64_t m_tick;
+    gf::Time m_clock; // simulation time
+    gf::Time m_lastStep;
+    EventQueue m_events; // on handles
+    std::vector<Handle> m_dyingHandles; // waiting to be out of sight
+
+    SpatialGrid m_grid; // indexed by handle slot
+    SpawnDirector m_spawner;
+
+    gf::Texture *m_atlasTexture; // loaded on first render, the simulation runs without a window
     std::vector< std::array< gf::Vector2f, 6> > m_cropBoxes;
+    std::vector<gf::Vertex> m_vertices;
+    std::vector<std::size_t> m_visibleSlots;
 
+    float m_forwardMove; // 1 to forward / -1 to backward
+    float m_sideMove; // 1 to rigth / -1 to left
+    std::size_t m_spawnLimit;
+    std::size_t m_minimumPopulation;
     bool m_isSprinting;
+    float m_interpolation;
     gf::RectF m_viewRect;
+    MessageBus::SubscriptionId m_viewSizeSubscription;
+    float m_cullingPadding;
+    std::size_t m_drawCalls;
+    std::size_t m_visibleCount;
+    std::size_t m_culledCount;
+    uint64_t m_spawnCount;
+    uint64_t m_despawnCount;
   };
 } /* kkd */
 
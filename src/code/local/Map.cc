@@ -17,45 +17,291 @@
  */
 #include "Map.h"
 
-#include <cassert>
+#include <algorithm>
+#include <cmath>
 
-#include <gf/Heightmap.h>
-#include <gf/Noises.h>
 #include <gf/RenderTarget.h>
 
+#include "AllocationTracker.h"
+#include "FrameArena.h"
+#include "FrameProfiler.h"
 #include "Singletons.h"
 
 namespace kkd {
 
-  Map::Map()
+  constexpr gf::Vector2f Map::WorldOrigin;
+  constexpr std::size_t Map::VerticesPerTile;
+
+  Map::Map(uint32_t seed)
   : m_texture(gResourceManager().getTexture("map.png"))
-  , m_layer({ Size, Size })
+  , m_tilesetColumns(std::max(static_cast<int>(m_texture.getSize().x / TileSize), 1))
+  , m_tileTextureSize(TileSize / m_texture.getSize().x, TileSize / m_texture.getSize().y)
+  , m_generator(seed)
+  , m_cache(ChunkCache::getDefaultDirectory(), m_generator.getSeed(), ChunkSize, TerrainGenerator::Version)
+  , m_viewRect({ 0.0f, 0.0f }, { 0.0f, 0.0f })
+  , m_frame(0)
+  , m_submittedChunks(0)
+  , m_submittedTiles(0)
+  , m_stop(false)
   {
-    m_layer.setTexture(m_texture);
-    m_layer.setTileSize({ 64u, 64u });
+    m_viewSizeSubscription = gMessageBus().subscribe(this, &Map::onViewSize);
+
+    for (unsigned i = 0; i < GeneratorThreads; ++i) {
+      m_threads.emplace_back(&Map::runGenerator, this);
+    }
+  }
 
-    gf::Heightmap heightmap({ (int)Size, (int)Size });
-    heightmap.reset();
+  Map::~Map() {
+    gMessageBus().unsubscribe(m_viewSizeSubscription);
 
-    gf::PerlinNoise2D noise(gRandom(), 2);
-    heightmap.addNoise(noise);
-    heightmap.normalize();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
 
-    for (unsigned y = 0; y < Size; ++y) {
-      for (unsigned x = 0; x < Size; ++x) {
-        double value = heightmap.getValue({ static_cast<int>(x), static_cast<int>(y) });
-        assert(0.0 <= value && value <= 1.0);
-        int tile = static_cast<int>(value * 3.999999);
-        assert(0 <= tile && tile <= 3);
-        m_layer.setTile({ x, y }, tile);
-      }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads) {
+      thread.join();
     }
+  }
+
+  void Map::update(gf::Time time) {
+    (void) time;
+    AllocationTracker::Scope allocationScope(Subsystem::Map);
+    FrameProfiler::Zone zone("Map::update");
 
-    m_layer.setOrigin({ 64.f * Size / 2, 64.f * Size / 2 });
+    ++m_frame;
+    loadGeneratedChunks();
+    requestChunks();
+    evictChunks();
   }
 
   void Map::render(gf::RenderTarget &target, const gf::RenderStates &states) {
-    target.draw(m_layer, states);
+    AllocationTracker::Scope allocationScope(Subsystem::Map);
+    FrameProfiler::Zone zone("Map::render");
+
+    gf::RenderStates localStates = states;
+    localStates.texture = &m_texture;
+
+    m_submittedChunks = 0;
+
+    // the view rect comes from the start of the frame, the camera may have
+    // moved since
+    gf::RectF cullRect(
+      { m_viewRect.left - CullingPadding, m_viewRect.top - CullingPadding },
+      { m_viewRect.width + 2 * CullingPadding, m_viewRect.height + 2 * CullingPadding }
+    );
+
+    for (auto& entry : m_chunks) {
+      Chunk& chunk = entry.second;
+
+      if (cullRect.intersects(getChunkBounds(chunk.coords))) {
+        chunk.lastUsed = m_frame;
+        target.draw(chunk.geometry, localStates);
+        ++m_submittedChunks;
+      }
+    }
+
+    m_submittedTiles = m_submittedChunks * ChunkSize * ChunkSize;
+  }
+
+  void Map::onViewSize(const ViewSize& message) {
+    m_viewRect = gf::RectF(message.viewCenter - 0.5f * message.viewSize, message.viewSize);
+  }
+
+  std::size_t Map::getLoadedChunkCount() const {
+    return m_chunks.size();
+  }
+
+  std::size_t Map::getPendingChunkCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+  }
+
+  std::size_t Map::getSubmittedChunkCount() const {
+    return m_submittedChunks;
+  }
+
+  std::size_t Map::getSubmittedTileCount() const {
+    return m_submittedTiles;
+  }
+
+  std::size_t Map::getSubmittedVertexCount() const {
+    return m_submittedTiles * VerticesPerTile;
+  }
+
+  Map::ChunkKey Map::getKey(gf::Vector2i coords) {
+    return (static_cast<ChunkKey>(static_cast<uint32_t>(coords.y)) << 32) | static_cast<uint32_t>(coords.x);
+  }
+
+  gf::RectF Map::getChunkBounds(gf::Vector2i coords) const {
+    const float chunkWorldSize = ChunkSize * TileSize;
+    return gf::RectF(WorldOrigin + chunkWorldSize * gf::Vector2f(coords.x, coords.y), { chunkWorldSize, chunkWorldSize });
+  }
+
+  void Map::requestChunks() {
+    const float chunkWorldSize = ChunkSize * TileSize;
+
+    gf::Vector2f center = m_viewRect.getCenter();
+    int minX = static_cast<int>(std::floor((m_viewRect.left - WorldOrigin.x) / chunkWorldSize)) - LoadMargin;
+    int minY = static_cast<int>(std::floor((m_viewRect.top - WorldOrigin.y) / chunkWorldSize)) - LoadMargin;
+    int maxX = static_cast<int>(std::floor((m_viewRect.left + m_viewRect.width - WorldOrigin.x) / chunkWorldSize)) + LoadMargin;
+    int maxY = static_cast<int>(std::floor((m_viewRect.top + m_viewRect.height - WorldOrigin.y) / chunkWorldSize)) + LoadMargin;
+
+    FrameVector<gf::Vector2i> missing { FrameAllocator<gf::Vector2i>(gFrameArena()) };
+
+    for (int y = minY; y <= maxY; ++y) {
+      for (int x = minX; x <= maxX; ++x) {
+        auto it = m_chunks.find(getKey({ x, y }));
+
+        if (it != m_chunks.end()) {
+          it->second.lastUsed = m_frame;
+        } else {
+          missing.push_back({ x, y });
+        }
+      }
+    }
+
+    // the closest chunks first
+    std::sort(missing.begin(), missing.end(), [this, center](gf::Vector2i lhs, gf::Vector2i rhs) {
+      return gf::squareDistance(getChunkBounds(lhs).getCenter(), center) < gf::squareDistance(getChunkBounds(rhs).getCenter(), center);
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      // the requests of the last frame may be out of the view now
+      for (auto coords : m_requests) {
+        m_pending.erase(getKey(coords));
+      }
+
+      m_requests.clear();
+
+      for (auto coords : missing) {
+        if (m_pending.insert(getKey(coords)).second) {
+          m_requests.push_back(coords);
+        }
+      }
+    }
+
+    m_condition.notify_all();
+  }
+
+  void Map::loadGeneratedChunks() {
+    std::vector<GeneratedChunk> generated;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      generated.swap(m_generated);
+
+      for (auto& chunk : generated) {
+        m_pending.erase(getKey(chunk.coords));
+      }
+    }
+
+    // the vertex buffers are created on the main thread
+    for (auto& data : generated) {
+      Chunk& chunk = m_chunks[getKey(data.coords)];
+      chunk.coords = data.coords;
+      chunk.geometry = gf::VertexBuffer(data.vertices.data(), data.vertices.size(), gf::PrimitiveType::Triangles);
+      chunk.lastUsed = m_frame;
+    }
+  }
+
+  void Map::evictChunks() {
+    if (m_chunks.size() <= MaxChunks) {
+      return;
+    }
+
+    // least recently used first, the chunks of this frame are kept
+    FrameVector<std::pair<uint64_t, ChunkKey>> candidates { FrameAllocator<std::pair<uint64_t, ChunkKey>>(gFrameArena()) };
+
+    for (auto& entry : m_chunks) {
+      if (entry.second.lastUsed != m_frame) {
+        candidates.push_back({ entry.second.lastUsed, entry.first });
+      }
+    }
+
+    std::size_t count = std::min(m_chunks.size() - MaxChunks, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      m_chunks.erase(candidates[i].second);
+    }
+  }
+
+  void Map::runGenerator() {
+    AllocationTracker::Scope allocationScope(Subsystem::Map);
+
+    for (;;) {
+      GeneratedChunk chunk;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+
+        if (m_stop) {
+          return;
+        }
+
+        chunk.coords = m_requests.front();
+        m_requests.pop_front();
+      }
+
+      uint8_t tiles[ChunkSize * ChunkSize];
+
+      if (!m_cache.load(chunk.coords, tiles)) {
+        m_generator.generate(chunk.coords * ChunkSize, ChunkSize, tiles);
+        m_cache.store(chunk.coords, tiles);
+      }
+
+      computeGeometry(chunk.coords, tiles, chunk.vertices);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_generated.push_back(std::move(chunk));
+    }
+  }
+
+  void Map::computeGeometry(gf::Vector2i coords, const uint8_t *tiles, std::vector<gf::Vertex>& vertices) const {
+    // same geometry as a gf::TileLayer, in world coordinates
+    gf::Vector2f origin = getChunkBounds(coords).getTopLeft();
+
+    vertices.resize(ChunkSize * ChunkSize * VerticesPerTile);
+    gf::Vertex *quad = vertices.data();
+
+    for (int y = 0; y < ChunkSize; ++y) {
+      for (int x = 0; x < ChunkSize; ++x) {
+        int tile = *tiles++;
+
+        gf::Vector2f position = origin + TileSize * gf::Vector2f(x, y);
+        gf::Vector2f texCoords = m_tileTextureSize * gf::Vector2f(tile % m_tilesetColumns, tile / m_tilesetColumns);
+
+        gf::Vertex topLeft;
+        topLeft.position = position;
+        topLeft.texCoords = texCoords;
+
+        gf::Vertex topRight;
+        topRight.position = position + gf::Vector2f(TileSize, 0.0f);
+        topRight.texCoords = texCoords + gf::Vector2f(m_tileTextureSize.x, 0.0f);
+
+        gf::Vertex bottomLeft;
+        bottomLeft.position = position + gf::Vector2f(0.0f, TileSize);
+        bottomLeft.texCoords = texCoords + gf::Vector2f(0.0f, m_tileTextureSize.y);
+
+        gf::Vertex bottomRight;
+        bottomRight.position = position + gf::Vector2f(TileSize, TileSize);
+        bottomRight.texCoords = texCoords + m_tileTextureSize;
+
+        quad[0] = topLeft;
+        quad[1] = topRight;
+        quad[2] = bottomLeft;
+        quad[3] = bottomLeft;
+        quad[4] = topRight;
+        quad[5] = bottomRight;
+        quad += VerticesPerTile;
+      }
+    }
   }
 
 }
@@ -15,27 +15,116 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
+
 #ifndef KKD_MAP_H
 #define KKD_MAP_H
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <gf/Entity.h>
+#include <gf/Rect.h>
 #include <gf/Texture.h>
-#include <gf/TileLayer.h>
+#include <gf/Vector.h>
+#include <gf/Vertex.h>
+#include <gf/VertexBuffer.h>
+
+#include "ChunkCache.h"
+#include "MessageBus.h"
+#include "Messages.h"
+#include "TerrainGenerator.h"
 
 namespace kkd {
 
+  // The world is split in chunks of tiles, generated in the background
+  // around the view. The geometry of a chunk is uploaded once in a vertex
+  // buffer, and only the chunks that intersect the view are drawn. The
+  // chunks that are not used anymore are evicted when there are more than
+  // MaxChunks.
   class Map : public gf::Entity {
   public:
-    Map();
+    // the map does not draw from gRandom, so that the simulation does not
+    // depend on it
+    explicit Map(uint32_t seed);
+    ~Map();
+
+    Map(const Map&) = delete;
+    Map& operator=(const Map&) = delete;
 
+    virtual void update(gf::Time time) override;
     virtual void render(gf::RenderTarget &target, const gf::RenderStates &states) override;
 
+    void onViewSize(const ViewSize& message);
+
+    std::size_t getLoadedChunkCount() const;
+    std::size_t getPendingChunkCount() const;
+
+    // chunks and tiles submitted by the last render
+    std::size_t getSubmittedChunkCount() const;
+    std::size_t getSubmittedTileCount() const;
+    std::size_t getSubmittedVertexCount() const;
+
   private:
-    static constexpr unsigned Size = 75;
+    static constexpr int ChunkSize = 16; // in tiles
+    static constexpr float TileSize = 64.0f;
+    static constexpr gf::Vector2f WorldOrigin = { - TileSize * 75 / 2, - TileSize * 75 / 2 }; // world position of the tile (0, 0)
+    static constexpr int LoadMargin = 1; // in chunks around the view
+    static constexpr float CullingPadding = TileSize; // more than the camera moves between the view message and the draw
+    static constexpr std::size_t MaxChunks = 96;
+    static constexpr unsigned GeneratorThreads = 2;
+    static constexpr std::size_t VerticesPerTile = 6;
+
+    using ChunkKey = uint64_t;
+
+    struct Chunk {
+      gf::Vector2i coords;
+      gf::VertexBuffer geometry;
+      uint64_t lastUsed; // frame
+    };
+
+    struct GeneratedChunk {
+      gf::Vector2i coords;
+      std::vector<gf::Vertex> vertices; // uploaded on the main thread
+    };
+
+    static ChunkKey getKey(gf::Vector2i coords);
+    gf::RectF getChunkBounds(gf::Vector2i coords) const;
+    void requestChunks();
+    void loadGeneratedChunks();
+    void evictChunks();
+    void runGenerator();
+    void computeGeometry(gf::Vector2i coords, const uint8_t *tiles, std::vector<gf::Vertex>& vertices) const;
 
   private:
     gf::Texture& m_texture;
-    gf::TileLayer m_layer;
+    int m_tilesetColumns; // tiles in a row of the texture
+    gf::Vector2f m_tileTextureSize; // in texture coordinates
+    TerrainGenerator m_generator;
+    ChunkCache m_cache;
+
+    std::unordered_map<ChunkKey, Chunk> m_chunks;
+    gf::RectF m_viewRect;
+    MessageBus::SubscriptionId m_viewSizeSubscription;
+    uint64_t m_frame;
+    std::size_t m_submittedChunks;
+    std::size_t m_submittedTiles;
+
+    // shared with the generator threads
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<gf::Vector2i> m_requests;
+    std::unordered_set<ChunkKey> m_pending; // requested or being generated
+    std::vector<GeneratedChunk> m_generated;
+    bool m_stop;
+
+    std::vector<std::thread> m_threads;
   };
 
 
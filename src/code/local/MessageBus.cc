@@ -0,0 +1,79 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MessageBus.h"
+
+#include "FrameProfiler.h"
+
+namespace kkd {
+
+  constexpr MessageBus::SubscriptionId MessageBus::NoSubscription;
+
+  MessageBus::MessageBus()
+  : m_nextId(NoSubscription + 1)
+  {
+  }
+
+  MessageBus::~MessageBus() = default;
+
+  void MessageBus::dispatch() {
+    FrameProfiler::Zone zone("MessageBus::dispatch");
+
+    // a handler may post to a type that was already dispatched, or use a
+    // new type
+    bool delivered;
+
+    do {
+      delivered = false;
+
+      for (std::size_t i = 0; i < m_order.size(); ++i) {
+        delivered = m_channels[m_order[i]]->dispatch() || delivered;
+      }
+    } while (delivered);
+  }
+
+  void MessageBus::unsubscribe(SubscriptionId id) {
+    for (auto& channel : m_channels) {
+      if (channel && channel->unsubscribe(id)) {
+        return;
+      }
+    }
+  }
+
+  std::size_t MessageBus::getMessageTypeCount() const {
+    return m_order.size();
+  }
+
+  MessageStats MessageBus::getStats(std::size_t index) const {
+    assert(index < m_order.size());
+    return m_channels[m_order[index]]->getStats();
+  }
+
+  MessageStats MessageBus::Channel::getStats() const {
+    MessageStats stats;
+    stats.name = name;
+    stats.count = count;
+    stats.handlerTime = gf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    return stats;
+  }
+
+  std::size_t MessageBus::createTypeIndex() {
+    static std::size_t count = 0;
+    return count++;
+  }
+
+}
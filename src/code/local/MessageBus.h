@@ -0,0 +1,235 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_MESSAGE_BUS_H
+#define KKD_MESSAGE_BUS_H
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <gf/Time.h>
+
+namespace kkd {
+
+  struct MessageStats {
+    const char *name;
+    std::size_t count; // messages delivered
+    gf::Time handlerTime;
+  };
+
+  // Messages are plain structures with a static Name. Every message type
+  // has its own channel, found by an index given to the type on its first
+  // use, so that sending a message does not look anything up by id.
+  //
+  // A message is either sent, and the handlers are called at once, or
+  // posted, and the handlers are called at the next dispatch(), in the
+  // order of the posts for a given type. It is meant to be used from the
+  // main thread only.
+  //
+  // An object that subscribes must unsubscribe before it is destroyed,
+  // with the id returned by subscribe().
+  class MessageBus {
+  public:
+    using SubscriptionId = uint64_t;
+
+    MessageBus();
+    ~MessageBus();
+
+    MessageBus(const MessageBus&) = delete;
+    MessageBus& operator=(const MessageBus&) = delete;
+
+    template<typename Message, typename Func>
+    SubscriptionId subscribe(Func func) {
+      SubscriptionId id = m_nextId++;
+      getChannel<Message>().handlers.push_back({ id, std::move(func) });
+      return id;
+    }
+
+    template<typename Message, typename Object>
+    SubscriptionId subscribe(Object *object, void (Object::*method)(const Message&)) {
+      return subscribe<Message>([object, method](const Message& message) {
+        (object->*method)(message);
+      });
+    }
+
+    // the handler is not called anymore, even by a delivery in progress
+    void unsubscribe(SubscriptionId id);
+
+    template<typename Message>
+    void send(const Message& message) {
+      getChannel<Message>().deliver(message);
+    }
+
+    template<typename Message>
+    void post(const Message& message) {
+      getChannel<Message>().queue.push_back(message);
+    }
+
+    // deliver the posted messages, type by type in the order of their
+    // first use, until every queue is empty: the messages posted by the
+    // handlers are delivered too, so handlers must not post each other
+    // forever
+    void dispatch();
+
+    // one entry per message type used so far
+    std::size_t getMessageTypeCount() const;
+    MessageStats getStats(std::size_t index) const;
+
+    template<typename Message>
+    MessageStats getStats() {
+      return getChannel<Message>().getStats();
+    }
+
+  private:
+    struct Channel {
+      explicit Channel(const char *name)
+      : name(name)
+      , count(0)
+      , elapsed(0)
+      {
+      }
+
+      virtual ~Channel() = default;
+      // false if there was nothing to deliver
+      virtual bool dispatch() = 0;
+      // false if the handler is not in this channel
+      virtual bool unsubscribe(SubscriptionId id) = 0;
+
+      MessageStats getStats() const;
+
+      const char *name;
+      std::size_t count;
+      std::chrono::nanoseconds elapsed; // in the handlers
+    };
+
+    template<typename Message>
+    struct TypedChannel : Channel {
+      struct Handler {
+        SubscriptionId id; // NoSubscription once unsubscribed
+        std::function<void(const Message&)> func;
+      };
+
+      explicit TypedChannel(const char *name)
+      : Channel(name)
+      , depth(0)
+      {
+      }
+
+      void deliver(const Message& message) {
+        auto start = std::chrono::steady_clock::now();
+        ++depth;
+
+        // a handler may subscribe during the delivery, by index
+        for (std::size_t i = 0; i < handlers.size(); ++i) {
+          if (handlers[i].id != NoSubscription) {
+            handlers[i].func(message);
+          }
+        }
+
+        // the handlers removed meanwhile are destroyed once no one runs
+        if (--depth == 0) {
+          handlers.erase(std::remove_if(handlers.begin(), handlers.end(), [](const Handler& handler) {
+            return handler.id == NoSubscription;
+          }), handlers.end());
+        }
+
+        ++count;
+        elapsed += std::chrono::steady_clock::now() - start;
+      }
+
+      virtual bool unsubscribe(SubscriptionId id) override {
+        for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+          if (it->id != id) {
+            continue;
+          }
+
+          if (depth > 0) {
+            it->id = NoSubscription;
+          } else {
+            handlers.erase(it);
+          }
+
+          return true;
+        }
+
+        return false;
+      }
+
+      virtual bool dispatch() override {
+        if (queue.empty()) {
+          return false;
+        }
+
+        // the queue may grow during the loop
+        for (std::size_t i = 0; i < queue.size(); ++i) {
+          Message message = queue[i];
+          deliver(message);
+        }
+
+        queue.clear();
+        return true;
+      }
+
+      std::deque<Handler> handlers; // stay in place when a handler subscribes
+      std::vector<Message> queue;
+      int depth; // deliveries in progress
+    };
+
+    static constexpr SubscriptionId NoSubscription = 0;
+
+    static std::size_t createTypeIndex();
+
+    template<typename Message>
+    static std::size_t getTypeIndex() {
+      static const std::size_t index = createTypeIndex();
+      return index;
+    }
+
+    template<typename Message>
+    TypedChannel<Message>& getChannel() {
+      std::size_t index = getTypeIndex<Message>();
+
+      if (index >= m_channels.size()) {
+        m_channels.resize(index + 1);
+      }
+
+      if (!m_channels[index]) {
+        const char *name = Message::Name; // not bound to a reference, no definition needed
+        m_channels[index] = std::make_unique<TypedChannel<Message>>(name);
+        m_order.push_back(index);
+      }
+
+      return static_cast<TypedChannel<Message>&>(*m_channels[index]);
+    }
+
+  private:
+    std::vector<std::unique_ptr<Channel>> m_channels; // by type index
+    std::vector<std::size_t> m_order; // type indices in the order of their first use
+    SubscriptionId m_nextId;
+  };
+
+}
+
+#endif // KKD_MESSAGE_BUS_H
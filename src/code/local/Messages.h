@@ -2,38 +2,38 @@
 #define KKD_MESSAGES_H
 
 #include <gf/Gamepad.h>
-#include <gf/Message.h>
-
-using namespace gf::literals;
+#include <gf/Vector.h>
 
 namespace kkd {
 
-  struct KrokodilePosition : public gf::Message {
-    static constexpr gf::Id type = "KrokodilePosition"_id;
+  // the messages of the MessageBus
+
+  struct KrokodilePosition {
+    static constexpr const char *Name = "KrokodilePosition";
 
     gf::Vector2f position;
     float angle;
   };
 
-  struct KrokodileStats : public gf::Message {
-    static constexpr gf::Id type = "KrokodileStats"_id;
+  struct KrokodileStats {
+    static constexpr const char *Name = "KrokodileStats";
 
     float foodLevel;
     int ageLevel;
   };
 
-  struct CompleteGame: public gf::Message {
-    static constexpr gf::Id type = "Complete"_id;
+  struct CompleteGame {
+    static constexpr const char *Name = "CompleteGame";
   };
 
-  struct GamepadConnected: public gf::Message {
-    static constexpr gf::Id type = "GamepadConnected"_id;
+  struct GamepadConnected {
+    static constexpr const char *Name = "GamepadConnected";
 
     gf::GamepadId gamepadId;
   };
 
-  struct ViewSize: public gf::Message {
-    static constexpr gf::Id type = "ViewSize"_id;
+  struct ViewSize {
+    static constexpr const char *Name = "ViewSize";
 
     gf::Vector2f viewSize;
     gf::Vector2f viewCenter;
@@ -0,0 +1,139 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "PerlinField.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+#include <gf/Math.h>
+
+namespace kkd {
+
+  namespace {
+    constexpr std::size_t RowBlock = 64; // samples computed together
+
+    // defaults of gf::FractalNoise2D
+    constexpr double Lacunarity = 2.0;
+    constexpr double Persistence = 0.5;
+
+    inline double quinticStep(double t) {
+      return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+    }
+
+    inline double lerp(double lhs, double rhs, double t) {
+      return (1.0 - t) * lhs + t * rhs;
+    }
+  }
+
+  constexpr std::size_t PerlinField::TableSize;
+
+  PerlinField::PerlinField(gf::Random& random, double scale, std::size_t octaves)
+  : m_scale(scale)
+  , m_octaves(octaves)
+  {
+    // same draws as gf::GradientNoise2D
+
+    for (std::size_t i = 0; i < TableSize; ++i) {
+      m_permutation[i] = static_cast<uint8_t>(i);
+    }
+
+    std::shuffle(m_permutation.begin(), m_permutation.end(), random.getEngine());
+
+    std::uniform_real_distribution<double> dist(0.0, 2.0 * gf::Pi);
+
+    for (std::size_t i = 0; i < TableSize; ++i) {
+      double angle = dist(random.getEngine());
+      m_gradientsX[i] = std::cos(angle);
+      m_gradientsY[i] = std::sin(angle);
+    }
+  }
+
+  double PerlinField::getValue(double x, double y) const {
+    double value;
+    computeRow(&x, 1, y, &value);
+    return value;
+  }
+
+  void PerlinField::computeRow(const double *xs, std::size_t count, double y, double *values) const {
+    assert(y >= 0.0);
+
+    const double *gradientsX = m_gradientsX.data();
+    const double *gradientsY = m_gradientsY.data();
+
+    // the operations are done in the order of gf, so that the results are
+    // exactly the same; on non-negative coordinates, x - trunc(x) is the
+    // std::fmod(x, 1) of gf and is exact
+    double scaledXs[RowBlock];
+    int64_t cellXs[RowBlock];
+
+    for (std::size_t begin = 0; begin < count; begin += RowBlock) {
+      const std::size_t size = std::min(RowBlock, count - begin);
+      double *blockValues = values + begin;
+
+      for (std::size_t i = 0; i < size; ++i) {
+        assert(xs[begin + i] >= 0.0);
+        scaledXs[i] = xs[begin + i] * m_scale;
+        blockValues[i] = 0.0;
+      }
+
+      double frequency = 1.0;
+      double amplitude = 1.0;
+
+      for (std::size_t k = 0; k < m_octaves; ++k) {
+        const double fy = y * m_scale * frequency;
+        const int64_t cellY = static_cast<int64_t>(fy);
+        const double ry = fy - static_cast<double>(cellY);
+        const double uy = quinticStep(ry);
+        const unsigned p0 = m_permutation[cellY & 0xFF];
+        const unsigned p1 = m_permutation[(cellY + 1) & 0xFF];
+
+        for (std::size_t i = 0; i < size; ++i) {
+          cellXs[i] = static_cast<int64_t>(scaledXs[i] * frequency);
+        }
+
+        for (std::size_t i = 0; i < size; ++i) {
+          const double fx = scaledXs[i] * frequency;
+          const unsigned qx = static_cast<unsigned>(cellXs[i]) & 0xFF;
+          const double rx = fx - static_cast<double>(cellXs[i]);
+
+          const unsigned i00 = (qx + p0) & 0xFF;
+          const unsigned i10 = (qx + 1 + p0) & 0xFF;
+          const unsigned i01 = (qx + p1) & 0xFF;
+          const unsigned i11 = (qx + 1 + p1) & 0xFF;
+
+          const double n00 = gradientsX[i00] * rx + gradientsY[i00] * ry;
+          const double n10 = gradientsX[i10] * (rx - 1.0) + gradientsY[i10] * ry;
+          const double n01 = gradientsX[i01] * rx + gradientsY[i01] * (ry - 1.0);
+          const double n11 = gradientsX[i11] * (rx - 1.0) + gradientsY[i11] * (ry - 1.0);
+
+          const double ux = quinticStep(rx);
+          const double nx0 = lerp(n00, n10, ux);
+          const double nx1 = lerp(n01, n11, ux);
+
+          blockValues[i] += lerp(nx0, nx1, uy) * amplitude;
+        }
+
+        frequency *= Lacunarity;
+        amplitude *= Persistence;
+      }
+    }
+  }
+
+}
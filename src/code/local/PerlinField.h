@@ -0,0 +1,59 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_PERLIN_FIELD_H
+#define KKD_PERLIN_FIELD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <gf/Random.h>
+
+namespace kkd {
+
+  // The noise of gf::PerlinNoise2D, built from the same draws of the
+  // generator, so the values are the same for the same seed. It is
+  // evaluated a row at a time: the part of the computation that only
+  // depends on y is done once per row and the loop over the samples has no
+  // branch, so that the compiler can vectorize it.
+  //
+  // As for gf::PerlinNoise2D, the coordinates must not be negative.
+  class PerlinField {
+  public:
+    PerlinField(gf::Random& random, double scale, std::size_t octaves = 8);
+
+    double getValue(double x, double y) const;
+
+    // values[i] = getValue(xs[i], y), it can be called from several threads
+    // at once
+    void computeRow(const double *xs, std::size_t count, double y, double *values) const;
+
+  private:
+    static constexpr std::size_t TableSize = 256;
+
+    std::array<uint8_t, TableSize> m_permutation;
+    std::array<double, TableSize> m_gradientsX;
+    std::array<double, TableSize> m_gradientsY;
+    double m_scale;
+    std::size_t m_octaves;
+  };
+
+}
+
+#endif // KKD_PERLIN_FIELD_H
@@ -0,0 +1,204 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ProfilerOverlay.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <gf/Anchor.h>
+#include <gf/Color.h>
+#include <gf/Coordinates.h>
+
+#include "FrameProfiler.h"
+#include "Singletons.h"
+
+namespace kkd {
+
+  namespace {
+    constexpr float Padding = 15.0f;
+    constexpr float BarWidth = 1.0f; // per frame
+    constexpr float GraphWidth = FrameProfiler::HistorySize * BarWidth;
+    constexpr float GraphHeight = 100.0f;
+    constexpr float GraphRange = 50.0f; // in milliseconds
+    constexpr float TargetFrameTime = 1000.0f / 60.0f;
+    constexpr unsigned CharacterSize = 14;
+    constexpr gf::Time RefreshPeriod = gf::seconds(0.25f);
+
+    gf::Color4f getFrameColor(float milliseconds) {
+      if (milliseconds <= TargetFrameTime) {
+        return gf::Color::Green;
+      }
+
+      if (milliseconds <= 2.0f * TargetFrameTime) {
+        return gf::Color::Yellow;
+      }
+
+      return gf::Color::Red;
+    }
+  }
+
+  ProfilerOverlay::ProfilerOverlay(const Hud& hud)
+  : gf::Entity(20) // above the hud
+  , m_font(gResourceManager().getFont("blkchcry.ttf"))
+  , m_hud(hud)
+  , m_visible(false)
+  , m_sinceRefresh(RefreshPeriod)
+  , m_hudRebuilds(0)
+  , m_hudFrames(0)
+  {
+    m_background.setColor(gf::Color4f(0.0f, 0.0f, 0.0f, 0.6f));
+
+    m_text.setFont(m_font);
+    m_text.setCharacterSize(CharacterSize);
+    m_text.setColor(gf::Color::White);
+
+    m_bars.resize(FrameProfiler::HistorySize * 6);
+    m_lines.resize(4);
+  }
+
+  void ProfilerOverlay::toggle() {
+    m_visible = !m_visible;
+    m_sinceRefresh = RefreshPeriod;
+    m_hudRebuilds = 0;
+    m_hudFrames = 0;
+  }
+
+  bool ProfilerOverlay::isVisible() const {
+    return m_visible;
+  }
+
+  void ProfilerOverlay::update(gf::Time time) {
+    m_sinceRefresh += time;
+  }
+
+  void ProfilerOverlay::render(gf::RenderTarget& target, const gf::RenderStates& states) {
+    if (!m_visible) {
+      return;
+    }
+
+    if (m_sinceRefresh >= RefreshPeriod) {
+      m_sinceRefresh = gf::Time();
+      updateText();
+    }
+
+    // the hud is rendered before, its count is the one of this frame
+    m_hudRebuilds += m_hud.getRebuildCount();
+    ++m_hudFrames;
+
+    gf::Coordinates coords(target);
+    gf::Vector2f topRight = coords.getAbsolutePoint({ Padding, Padding }, gf::Anchor::TopRight);
+
+    gf::RectF textBounds = m_text.getLocalBounds();
+    float width = std::max(GraphWidth, textBounds.width) + 2.0f * Padding;
+    float height = GraphHeight + textBounds.height + 3.0f * Padding;
+    gf::Vector2f origin(topRight.x - width, topRight.y);
+
+    m_background.setSize({ width, height });
+    m_background.setPosition(origin);
+
+    updateGraph({ origin.x + Padding, origin.y + Padding });
+    m_text.setPosition({ origin.x + Padding, origin.y + GraphHeight + 2.0f * Padding });
+
+    target.draw(m_background, states);
+    target.draw(m_bars.data(), m_bars.size(), gf::PrimitiveType::Triangles, states);
+    target.draw(m_lines.data(), m_lines.size(), gf::PrimitiveType::Lines, states);
+    target.draw(m_text, states);
+  }
+
+  void ProfilerOverlay::updateText() {
+    float last = 0.0f;
+    float total = 0.0f;
+    float worst = 0.0f;
+    std::size_t count = FrameProfiler::getFrameTimeCount();
+
+    for (std::size_t i = 0; i < count; ++i) {
+      float frameTime = FrameProfiler::getFrameTime(i);
+      total += frameTime;
+      worst = std::max(worst, frameTime);
+      last = frameTime;
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "frame %.2f ms, mean %.2f ms, max %.2f ms\n", last, count > 0 ? total / count : 0.0f, worst);
+    m_buffer = line;
+
+    for (std::size_t i = 0; i < FrameProfiler::getZoneStatsCount(); ++i) {
+      ZoneStats stats = FrameProfiler::getZoneStats(i);
+      std::snprintf(line, sizeof(line), "%s: %.3f ms (%zu)\n", stats.name, stats.milliseconds, stats.calls);
+      m_buffer += line;
+    }
+
+    std::snprintf(line, sizeof(line), "hud rebuilds: %zu in %zu frames\n", m_hudRebuilds, m_hudFrames);
+    m_buffer += line;
+    m_hudRebuilds = 0;
+    m_hudFrames = 0;
+
+    if (FrameProfiler::getDroppedZoneCount() > 0) {
+      std::snprintf(line, sizeof(line), "%zu zones dropped\n", FrameProfiler::getDroppedZoneCount());
+      m_buffer += line;
+    }
+
+    if (FrameProfiler::isCapturing()) {
+      m_buffer += "capturing\n";
+    }
+
+    m_text.setString(m_buffer);
+    m_text.setAnchor(gf::Anchor::TopLeft);
+  }
+
+  void ProfilerOverlay::updateGraph(gf::Vector2f origin) {
+    std::size_t count = FrameProfiler::getFrameTimeCount();
+    gf::Vertex *bar = m_bars.data();
+
+    // the newest frame on the right
+    for (std::size_t i = 0; i < FrameProfiler::HistorySize; ++i) {
+      float frameTime = 0.0f;
+
+      if (i + count >= FrameProfiler::HistorySize) {
+        frameTime = FrameProfiler::getFrameTime(i + count - FrameProfiler::HistorySize);
+      }
+
+      float barHeight = std::min(frameTime / GraphRange, 1.0f) * GraphHeight;
+      float left = origin.x + i * BarWidth;
+      float bottom = origin.y + GraphHeight;
+      gf::Color4f color = getFrameColor(frameTime);
+
+      bar[0].position = { left, bottom - barHeight };
+      bar[1].position = { left + BarWidth, bottom - barHeight };
+      bar[2].position = { left, bottom };
+      bar[3].position = { left, bottom };
+      bar[4].position = { left + BarWidth, bottom - barHeight };
+      bar[5].position = { left + BarWidth, bottom };
+
+      for (std::size_t j = 0; j < 6; ++j) {
+        bar[j].color = color;
+      }
+
+      bar += 6;
+    }
+
+    // 60 and 30 frames per second
+    for (std::size_t i = 0; i < 2; ++i) {
+      float y = origin.y + GraphHeight - (i + 1) * TargetFrameTime / GraphRange * GraphHeight;
+      m_lines[2 * i].position = { origin.x, y };
+      m_lines[2 * i + 1].position = { origin.x + GraphWidth, y };
+      m_lines[2 * i].color = m_lines[2 * i + 1].color = gf::Color::Opaque(0.5f);
+    }
+  }
+
+}
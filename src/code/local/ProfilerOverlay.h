@@ -0,0 +1,69 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_PROFILER_OVERLAY_H
+#define KKD_PROFILER_OVERLAY_H
+
+#include <string>
+#include <vector>
+
+#include <gf/Entity.h>
+#include <gf/Font.h>
+#include <gf/RenderTarget.h>
+#include <gf/Shapes.h>
+#include <gf/Text.h>
+#include <gf/Time.h>
+#include <gf/Vertex.h>
+
+#include "Hud.h"
+
+namespace kkd {
+  // Draws the frame times of the FrameProfiler as a graph, the zones of
+  // the last frame, and the hud rebuilds since the last refresh. It is
+  // hidden by default, and the text is only rebuilt a few times per second.
+  class ProfilerOverlay : public gf::Entity {
+  public:
+    explicit ProfilerOverlay(const Hud& hud);
+
+    void toggle();
+    bool isVisible() const;
+
+    virtual void update(gf::Time time) override;
+    virtual void render(gf::RenderTarget& target, const gf::RenderStates& states) override;
+
+  private:
+    void updateText();
+    void updateGraph(gf::Vector2f origin);
+
+  private:
+    gf::Font& m_font;
+    const Hud& m_hud;
+    bool m_visible;
+    gf::Time m_sinceRefresh;
+    std::size_t m_hudRebuilds; // since the last refresh
+    std::size_t m_hudFrames;
+
+    gf::RectangleShape m_background;
+    gf::Text m_text;
+    std::string m_buffer;
+    std::vector<gf::Vertex> m_bars;
+    std::vector<gf::Vertex> m_lines;
+  };
+}
+
+#endif // KKD_PROFILER_OVERLAY_H
@@ -0,0 +1,106 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_RANDOM_H
+#define KKD_RANDOM_H
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+#include "RandomStream.h"
+
+namespace kkd {
+
+  // General purpose generator (xoshiro256**), with the interface of
+  // gf::Random used in the game. Its state is seeded through splitmix64.
+  class Random {
+  public:
+    Random()
+    : Random(seedFromDevice())
+    {
+    }
+
+    explicit Random(uint64_t seed) {
+      RandomStream stream(seed);
+
+      for (auto& word : m_state) {
+        word = stream.computeNext();
+      }
+    }
+
+    uint64_t computeNext() {
+      const uint64_t result = rotate(m_state[1] * 5, 7) * 9;
+      const uint64_t t = m_state[1] << 17;
+
+      m_state[2] ^= m_state[0];
+      m_state[3] ^= m_state[1];
+      m_state[1] ^= m_state[2];
+      m_state[0] ^= m_state[3];
+      m_state[2] ^= t;
+      m_state[3] = rotate(m_state[3], 45);
+
+      return result;
+    }
+
+    // in [min, max)
+    float computeUniformFloat(float min, float max) {
+      float unit = static_cast<float>(computeNext() >> 40) * (1.0f / 16777216.0f);
+      return min + (max - min) * unit;
+    }
+
+    // in [min, max], without bias
+    template<typename T>
+    T computeUniformInteger(T min, T max) {
+      static_assert(std::is_integral<T>::value, "T must be an integer type");
+      using Unsigned = typename std::make_unsigned<T>::type;
+
+      const uint64_t range = static_cast<uint64_t>(static_cast<Unsigned>(max - min)) + 1;
+
+      if (range == 0) { // the whole 64-bit range
+        return static_cast<T>(computeNext());
+      }
+
+      const uint64_t threshold = (0 - range) % range;
+      uint64_t value;
+
+      do {
+        value = computeNext();
+      } while (value < threshold);
+
+      return static_cast<T>(static_cast<Unsigned>(min) + static_cast<Unsigned>(value % range));
+    }
+
+    static uint64_t seedFromDevice() {
+      std::random_device device;
+      return (static_cast<uint64_t>(device()) << 32) ^ device();
+    }
+
+  private:
+    static uint64_t rotate(uint64_t x, int k) {
+      return (x << k) | (x >> (64 - k));
+    }
+
+  private:
+    uint64_t m_state[4];
+  };
+
+}
+
+#endif // KKD_RANDOM_H
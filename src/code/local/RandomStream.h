@@ -0,0 +1,67 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KKD_RANDOM_STREAM_H
+#define KKD_RANDOM_STREAM_H
+
+#include <cstdint>
+
+namespace kkd {
+
+  // Small counter-based generator (splitmix64) owned by a single kreature.
+  // Its stream only depends on the world seed, the kreature and the tick
+  // it was created, so that kreatures can be updated in any order, or in
+  // parallel, with the same result.
+  class RandomStream {
+  public:
+    explicit RandomStream(uint64_t seed = 0)
+    : m_state(seed)
+    {
+    }
+
+    RandomStream(uint64_t seed, uint64_t id, uint64_t tick)
+    : m_state(mix(mix(mix(seed) ^ id) ^ tick))
+    {
+    }
+
+    uint64_t computeNext() {
+      uint64_t z = m_state;
+      m_state += UINT64_C(0x9E3779B97F4A7C15);
+      return mix(z);
+    }
+
+    // in [min, max)
+    float computeUniformFloat(float min, float max) {
+      float unit = static_cast<float>(computeNext() >> 40) * (1.0f / 16777216.0f);
+      return min + (max - min) * unit;
+    }
+
+  private:
+    static uint64_t mix(uint64_t z) {
+      z += UINT64_C(0x9E3779B97F4A7C15);
+      z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+      z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+      return z ^ (z >> 31);
+    }
+
+  private:
+    uint64_t m_state;
+  };
+
+}
+
+#endif // KKD_RANDOM_STREAM_H
@@ -19,5 +19,7 @@
 #include "Singletons.h"
 
 gf::Singleton<gf::ResourceManager> kkd::gResourceManager;
-gf::Singleton<gf::MessageManager> kkd::gMessageManager;
-gf::Singleton<gf::Random> kkd::gRandom;
+gf::Singleton<kkd::MessageBus> kkd::gMessageBus;
+gf::Singleton<kkd::Random> kkd::gRandom;
+gf::Singleton<kkd::WorkerPool> kkd::gWorkerPool;
+gf::Singleton<kkd::FrameArena> kkd::gFrameArena;
@@ -19,15 +19,20 @@
 #ifndef _LOCAL_SINGLETONS_H
 #define _LOCAL_SINGLETONS_H
 
-#include <gf/MessageManager.h>
-#include <gf/Random.h>
 #include <gf/ResourceManager.h>
 #include <gf/Singleton.h>
 
+#include "FrameArena.h"
+#include "MessageBus.h"
+#include "Random.h"
+#include "WorkerPool.h"
+
 namespace kkd {
   extern gf::Singleton<gf::ResourceManager> gResourceManager;
-  extern gf::Singleton<gf::MessageManager> gMessageManager;
-  extern gf::Singleton<gf::Random> gRandom;
+  extern gf::Singleton<MessageBus> gMessageBus;
+  extern gf::Singleton<Random> gRandom;
+  extern gf::Singleton<WorkerPool> gWorkerPool;
+  extern gf::Singleton<FrameArena> gFrameArena; // reset at the start of every frame
 }
 
 #endif // _LOCAL_SINGLETONS_H
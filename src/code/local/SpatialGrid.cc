@@ -0,0 +1,168 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace kkd {
+
+  constexpr std::size_t SpatialGrid::InvalidId;
+  constexpr std::size_t SpatialGrid::InvalidCell;
+
+  SpatialGrid::SpatialGrid(const gf::RectF& bounds, float cellSize)
+  : m_origin(bounds.left, bounds.top)
+  , m_cellSize(cellSize)
+  , m_gridSize(static_cast<int>(std::ceil(bounds.width / cellSize)), static_cast<int>(std::ceil(bounds.height / cellSize)))
+  {
+    assert(cellSize > 0.0f);
+    m_gridSize.x = std::max(m_gridSize.x, 1);
+    m_gridSize.y = std::max(m_gridSize.y, 1);
+    m_heads.resize(static_cast<std::size_t>(m_gridSize.x) * m_gridSize.y, InvalidId);
+  }
+
+  void SpatialGrid::clear() {
+    std::fill(m_heads.begin(), m_heads.end(), InvalidId);
+    m_items.clear();
+  }
+
+  void SpatialGrid::reserve(std::size_t count) {
+    m_items.reserve(count);
+  }
+
+  void SpatialGrid::insert(std::size_t id, gf::Vector2f position) {
+    if (id >= m_items.size()) {
+      m_items.resize(id + 1, { gf::Vector2f(0.0f, 0.0f), InvalidCell, InvalidId, InvalidId });
+    }
+
+    assert(m_items[id].cell == InvalidCell);
+
+    m_items[id].position = position;
+    link(id, getCellIndex(getCellCoordinates(position)));
+  }
+
+  void SpatialGrid::remove(std::size_t id) {
+    assert(id < m_items.size());
+    assert(m_items[id].cell != InvalidCell);
+
+    unlink(id);
+  }
+
+  void SpatialGrid::update(std::size_t id, gf::Vector2f position) {
+    assert(id < m_items.size());
+    Item& item = m_items[id];
+    assert(item.cell != InvalidCell);
+
+    item.position = position;
+    std::size_t cell = getCellIndex(getCellCoordinates(position));
+
+    if (cell != item.cell) {
+      unlink(id);
+      link(id, cell);
+    }
+  }
+
+  std::size_t SpatialGrid::queryNearest(gf::Vector2f position, float maxDistance, std::size_t excluded) const {
+    gf::Vector2i center = getCellCoordinates(position);
+
+    std::size_t bestId = InvalidId;
+    float bestDistance = maxDistance * maxDistance;
+
+    int maxRing = std::max({ center.x, m_gridSize.x - 1 - center.x, center.y, m_gridSize.y - 1 - center.y });
+
+    for (int ring = 0; ring <= maxRing; ++ring) {
+      // every item of the next rings is at least this far
+      float ringDistance = std::max(ring - 1, 0) * m_cellSize;
+
+      if (ringDistance * ringDistance > bestDistance) {
+        break;
+      }
+
+      for (int y = center.y - ring; y <= center.y + ring; ++y) {
+        if (y < 0 || y >= m_gridSize.y) {
+          continue;
+        }
+
+        bool border = (y == center.y - ring || y == center.y + ring);
+        int step = border ? 1 : 2 * ring;
+
+        for (int x = center.x - ring; x <= center.x + ring; x += step) {
+          if (x < 0 || x >= m_gridSize.x) {
+            continue;
+          }
+
+          for (std::size_t id = m_heads[getCellIndex({ x, y })]; id != InvalidId; id = m_items[id].next) {
+            if (id == excluded) {
+              continue;
+            }
+
+            float distance = gf::squareDistance(position, m_items[id].position);
+
+            if (distance <= bestDistance) {
+              bestDistance = distance;
+              bestId = id;
+            }
+          }
+        }
+      }
+    }
+
+    return bestId;
+  }
+
+  gf::Vector2i SpatialGrid::getCellCoordinates(gf::Vector2f position) const {
+    int x = static_cast<int>(std::floor((position.x - m_origin.x) / m_cellSize));
+    int y = static_cast<int>(std::floor((position.y - m_origin.y) / m_cellSize));
+    return { std::min(std::max(x, 0), m_gridSize.x - 1), std::min(std::max(y, 0), m_gridSize.y - 1) };
+  }
+
+  std::size_t SpatialGrid::getCellIndex(gf::Vector2i coordinates) const {
+    return static_cast<std::size_t>(coordinates.y) * m_gridSize.x + coordinates.x;
+  }
+
+  void SpatialGrid::link(std::size_t id, std::size_t cell) {
+    Item& item = m_items[id];
+    item.cell = cell;
+    item.previous = InvalidId;
+    item.next = m_heads[cell];
+
+    if (item.next != InvalidId) {
+      m_items[item.next].previous = id;
+    }
+
+    m_heads[cell] = id;
+  }
+
+  void SpatialGrid::unlink(std::size_t id) {
+    Item& item = m_items[id];
+
+    if (item.previous != InvalidId) {
+      m_items[item.previous].next = item.next;
+    } else {
+      m_heads[item.cell] = item.next;
+    }
+
+    if (item.next != InvalidId) {
+      m_items[item.next].previous = item.previous;
+    }
+
+    item.cell = InvalidCell;
+  }
+
+}
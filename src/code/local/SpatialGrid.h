@@ -0,0 +1,115 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KKD_SPATIAL_GRID_H
+#define KKD_SPATIAL_GRID_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <gf/Rect.h>
+#include <gf/Vector.h>
+#include <gf/VectorOps.h>
+
+namespace kkd {
+
+  // Uniform grid over the world, used to find kreatures near a point.
+  // Positions outside the bounds are stored in the border cells. The items
+  // of a cell are linked through the items indexed by id, so that moving
+  // an item does not allocate once the ids are reserved.
+  class SpatialGrid {
+  public:
+    static constexpr std::size_t InvalidId = std::numeric_limits<std::size_t>::max();
+
+    SpatialGrid(const gf::RectF& bounds, float cellSize);
+
+    void clear();
+
+    // room for the ids lower than count
+    void reserve(std::size_t count);
+
+    void insert(std::size_t id, gf::Vector2f position);
+    void remove(std::size_t id);
+    void update(std::size_t id, gf::Vector2f position);
+
+    // closest item to position, except the excluded one, no further than maxDistance
+    std::size_t queryNearest(gf::Vector2f position, float maxDistance, std::size_t excluded = InvalidId) const;
+
+    // call func(id, position) for every item in the circle
+    template<typename Func>
+    void queryRadius(gf::Vector2f center, float radius, Func func) const {
+      const float squareRadius = radius * radius;
+
+      forEachItem(gf::RectF(center - gf::Vector2f(radius, radius), { 2 * radius, 2 * radius }), [&](std::size_t id, gf::Vector2f position) {
+        if (gf::squareDistance(center, position) <= squareRadius) {
+          func(id, position);
+        }
+      });
+    }
+
+    // call func(id, position) for every item in the rectangle
+    template<typename Func>
+    void queryRect(const gf::RectF& rect, Func func) const {
+      forEachItem(rect, [&](std::size_t id, gf::Vector2f position) {
+        if (rect.contains(position)) {
+          func(id, position);
+        }
+      });
+    }
+
+  private:
+    static constexpr std::size_t InvalidCell = std::numeric_limits<std::size_t>::max();
+
+    struct Item {
+      gf::Vector2f position;
+      std::size_t cell;
+      std::size_t previous; // in the cell
+      std::size_t next;
+    };
+
+    gf::Vector2i getCellCoordinates(gf::Vector2f position) const;
+    std::size_t getCellIndex(gf::Vector2i coordinates) const;
+    void link(std::size_t id, std::size_t cell);
+    void unlink(std::size_t id);
+
+    // call func(id, position) for every item in the cells of the rectangle
+    template<typename Func>
+    void forEachItem(const gf::RectF& rect, Func func) const {
+      gf::Vector2i min = getCellCoordinates({ rect.left, rect.top });
+      gf::Vector2i max = getCellCoordinates({ rect.left + rect.width, rect.top + rect.height });
+
+      for (int y = min.y; y <= max.y; ++y) {
+        for (int x = min.x; x <= max.x; ++x) {
+          for (std::size_t id = m_heads[getCellIndex({ x, y })]; id != InvalidId; id = m_items[id].next) {
+            func(id, m_items[id].position);
+          }
+        }
+      }
+    }
+
+  private:
+    gf::Vector2f m_origin;
+    float m_cellSize;
+    gf::Vector2i m_gridSize;
+    std::vector<std::size_t> m_heads; // first item of every cell
+    std::vector<Item> m_items; // by id
+  };
+
+}
+
+#endif // KKD_SPATIAL_GRID_H
@@ -0,0 +1,119 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SpawnDirector.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <gf/Math.h>
+
+namespace kkd {
+
+  SpawnDirector::SpawnDirector(const gf::RectF& world, std::size_t budget)
+  : m_world(world)
+  , m_exclusion({ world.left, world.top }, { 0.0f, 0.0f })
+  , m_budget(budget)
+  , m_queueDepth(0)
+  , m_regionCount(0)
+  {
+    assert(budget > 0);
+    updateRegions();
+  }
+
+  void SpawnDirector::setBudget(std::size_t budget) {
+    assert(budget > 0);
+    m_budget = budget;
+  }
+
+  void SpawnDirector::setExclusion(const gf::RectF& exclusion) {
+    m_exclusion = exclusion;
+    updateRegions();
+  }
+
+  std::size_t SpawnDirector::schedule(std::size_t missing) {
+    std::size_t count = m_regionCount > 0 ? std::min(missing, m_budget) : 0;
+    m_queueDepth = missing - count;
+    return count;
+  }
+
+  bool SpawnDirector::computePosition(Random& random, gf::Vector2f& position) const {
+    if (m_regionCount == 0) {
+      return false;
+    }
+
+    // choose a region with a probability proportional to its area, so that
+    // the positions are uniform over the allowed part of the world
+    float area = random.computeUniformFloat(0.0f, m_cumulativeAreas[m_regionCount - 1]);
+    std::size_t i = 0;
+
+    while (i + 1 < m_regionCount && area >= m_cumulativeAreas[i]) {
+      ++i;
+    }
+
+    const gf::RectF& region = m_regions[i];
+    position.x = random.computeUniformFloat(region.left, region.left + region.width);
+    position.y = random.computeUniformFloat(region.top, region.top + region.height);
+    return true;
+  }
+
+  std::size_t SpawnDirector::getQueueDepth() const {
+    return m_queueDepth;
+  }
+
+  void SpawnDirector::updateRegions() {
+    float worldRight = m_world.left + m_world.width;
+    float worldBottom = m_world.top + m_world.height;
+
+    // the exclusion, clipped to the world
+    float left = gf::clamp(m_exclusion.left, m_world.left, worldRight);
+    float right = gf::clamp(m_exclusion.left + m_exclusion.width, m_world.left, worldRight);
+    float top = gf::clamp(m_exclusion.top, m_world.top, worldBottom);
+    float bottom = gf::clamp(m_exclusion.top + m_exclusion.height, m_world.top, worldBottom);
+
+    //   +-----------+
+    //   |   above   |
+    //   +--+-----+--+
+    //   |  |     |  |
+    //   +--+-----+--+
+    //   |   below   |
+    //   +-----------+
+    gf::RectF candidates[4] = {
+      gf::RectF({ m_world.left, m_world.top }, { m_world.width, top - m_world.top }),
+      gf::RectF({ m_world.left, bottom }, { m_world.width, worldBottom - bottom }),
+      gf::RectF({ m_world.left, top }, { left - m_world.left, bottom - top }),
+      gf::RectF({ right, top }, { worldRight - right, bottom - top }),
+    };
+
+    m_regionCount = 0;
+    float total = 0.0f;
+
+    for (auto& candidate : candidates) {
+      float area = candidate.width * candidate.height;
+
+      if (area <= 0.0f) {
+        continue;
+      }
+
+      total += area;
+      m_regions[m_regionCount] = candidate;
+      m_cumulativeAreas[m_regionCount] = total;
+      ++m_regionCount;
+    }
+  }
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_SPAWN_DIRECTOR_H
+#define KKD_SPAWN_DIRECTOR_H
+
+#include <array>
+#include <cstddef>
+
+#include <gf/Rect.h>
+#include <gf/Vector.h>
+
+#include "Random.h"
+
+namespace kkd {
+
+  // Decides where and when the missing kreatures appear. The spawns are
+  // out of sight, and spread over several ticks with a budget per tick.
+  class SpawnDirector {
+  public:
+    SpawnDirector(const gf::RectF& world, std::size_t budget);
+
+    void setBudget(std::size_t budget);
+
+    // nothing appears in this area, clipped to the world
+    void setExclusion(const gf::RectF& exclusion);
+
+    // number of kreatures to spawn in this tick, the rest waits in the queue
+    std::size_t schedule(std::size_t missing);
+
+    // false if the whole world is excluded
+    bool computePosition(Random& random, gf::Vector2f& position) const;
+
+    // kreatures still missing after the last tick
+    std::size_t getQueueDepth() const;
+
+  private:
+    void updateRegions();
+
+  private:
+    gf::RectF m_world;
+    gf::RectF m_exclusion;
+    std::size_t m_budget;
+    std::size_t m_queueDepth;
+
+    // the world minus the exclusion, as up to four rectangles
+    std::array<gf::RectF, 4> m_regions;
+    std::array<float, 4> m_cumulativeAreas;
+    std::size_t m_regionCount;
+  };
+
+}
+
+#endif // KKD_SPAWN_DIRECTOR_H
@@ -0,0 +1,100 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TerrainGenerator.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <gf/Math.h>
+
+namespace kkd {
+
+  constexpr double TerrainGenerator::FeatureSize;
+  constexpr int TerrainGenerator::Period;
+  constexpr uint32_t TerrainGenerator::Version;
+
+  TerrainGenerator::TerrainGenerator(uint32_t seed)
+  : m_seed(seed)
+  , m_random(seed)
+  , m_noise(m_random, 2)
+  , m_min(0.0)
+  , m_max(1.0)
+  {
+    calibrate();
+  }
+
+  uint32_t TerrainGenerator::getSeed() const {
+    return m_seed;
+  }
+
+  void TerrainGenerator::generate(gf::Vector2i origin, int size, uint8_t *tiles) {
+    const double scale = 1.0 / (m_max - m_min);
+
+    std::vector<double> xs(size);
+    std::vector<double> values(size);
+
+    for (int x = 0; x < size; ++x) {
+      xs[x] = getCoordinate(origin.x + x);
+    }
+
+    for (int y = 0; y < size; ++y) {
+      m_noise.computeRow(xs.data(), size, getCoordinate(origin.y + y), values.data());
+
+      for (int x = 0; x < size; ++x) {
+        double value = gf::clamp((values[x] - m_min) * scale, 0.0, 1.0);
+        *tiles++ = static_cast<uint8_t>(value * (TileTypes - 0.000001));
+      }
+    }
+  }
+
+  void TerrainGenerator::calibrate() {
+    // the range of the noise over a large sample of the world, it plays the
+    // role of the normalization of the original heightmap
+    static constexpr int Samples = 64;
+    static constexpr double Extent = 16 * FeatureSize;
+
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    for (int y = 0; y < Samples; ++y) {
+      for (int x = 0; x < Samples; ++x) {
+        double value = m_noise.getValue(x * Extent / Samples / FeatureSize, y * Extent / Samples / FeatureSize);
+        min = std::min(min, value);
+        max = std::max(max, value);
+      }
+    }
+
+    if (min < max) {
+      m_min = min;
+      m_max = max;
+    }
+  }
+
+  double TerrainGenerator::getCoordinate(int tile) {
+    // the noise is only defined on non-negative coordinates
+    int wrapped = tile % Period;
+
+    if (wrapped < 0) {
+      wrapped += Period;
+    }
+
+    return wrapped / FeatureSize;
+  }
+
+}
@@ -0,0 +1,64 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KKD_TERRAIN_GENERATOR_H
+#define KKD_TERRAIN_GENERATOR_H
+
+#include <cstdint>
+
+#include <gf/Random.h>
+#include <gf/Vector.h>
+
+#include "PerlinField.h"
+
+namespace kkd {
+
+  // Computes the tiles of any part of an unbounded world from a seed. The
+  // noise is normalized with a range measured once, so that a tile does
+  // not depend on the chunk it is generated in. The world repeats itself
+  // every Period tiles, the period of the noise.
+  class TerrainGenerator {
+  public:
+    static constexpr int TileTypes = 4;
+    static constexpr double FeatureSize = 75.0; // in tiles, the size of the original map
+    static constexpr int Period = 256 * 75; // in tiles, a multiple of the period of the noise
+    static constexpr uint32_t Version = 2; // to change when the tiles of a seed change
+
+    explicit TerrainGenerator(uint32_t seed);
+
+    uint32_t getSeed() const;
+
+    // tiles of the square of size * size tiles starting at origin, row by
+    // row; it can be called from several threads at once
+    void generate(gf::Vector2i origin, int size, uint8_t *tiles);
+
+  private:
+    void calibrate();
+    static double getCoordinate(int tile);
+
+  private:
+    uint32_t m_seed;
+    gf::Random m_random;
+    PerlinField m_noise;
+    double m_min;
+    double m_max;
+  };
+
+}
+
+#endif // KKD_TERRAIN_GENERATOR_H
@@ -0,0 +1,182 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace kkd {
+
+  WorkerPool::WorkerPool(unsigned threadCount)
+  : m_available(0)
+  , m_pending(0)
+  , m_stop(false)
+  {
+    if (threadCount == 0) {
+      threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+      m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (unsigned i = 1; i < threadCount; ++i) {
+      m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+  }
+
+  WorkerPool::~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+
+    m_wakeup.notify_all();
+
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  std::size_t WorkerPool::getThreadCount() const {
+    return m_queues.size();
+  }
+
+  void WorkerPool::run(std::size_t count, std::size_t grain, Invoke invoke, void *context) {
+    if (count == 0) {
+      return;
+    }
+
+    grain = std::max(grain, std::size_t(1));
+
+    // not worth waking the workers
+    if (m_threads.empty() || count <= grain) {
+      invoke(context, 0, count);
+      return;
+    }
+
+    std::size_t taskCount = (count + grain - 1) / grain;
+    assert(m_pending == 0);
+    m_pending = taskCount;
+
+    // counted before they are published, so that a worker that takes one
+    // at once never brings the count below zero
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_available += taskCount;
+    }
+
+    for (std::size_t i = 0; i < taskCount; ++i) {
+      Task task;
+      task.invoke = invoke;
+      task.context = context;
+      task.begin = i * grain;
+      task.end = std::min(task.begin + grain, count);
+
+      Queue& queue = *m_queues[i % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(task);
+    }
+
+    m_wakeup.notify_all();
+
+    Task task;
+
+    while (findTask(0, task)) {
+      runTask(task);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+  }
+
+  bool WorkerPool::popTask(std::size_t queue, Task& task) {
+    Queue& own = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if (own.head == own.tasks.size()) {
+      return false;
+    }
+
+    task = own.tasks.back();
+    own.tasks.pop_back();
+
+    if (own.head == own.tasks.size()) {
+      own.tasks.clear();
+      own.head = 0;
+    }
+
+    --m_available;
+    return true;
+  }
+
+  bool WorkerPool::stealTask(std::size_t thief, Task& task) {
+    for (std::size_t i = 1; i < m_queues.size(); ++i) {
+      Queue& victim = *m_queues[(thief + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+
+      if (victim.head == victim.tasks.size()) {
+        continue;
+      }
+
+      task = victim.tasks[victim.head++];
+
+      if (victim.head == victim.tasks.size()) {
+        victim.tasks.clear();
+        victim.head = 0;
+      }
+
+      --m_available;
+      return true;
+    }
+
+    return false;
+  }
+
+  bool WorkerPool::findTask(std::size_t queue, Task& task) {
+    return popTask(queue, task) || stealTask(queue, task);
+  }
+
+  void WorkerPool::runTask(const Task& task) {
+    task.invoke(task.context, task.begin, task.end);
+
+    if (--m_pending == 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done.notify_all();
+    }
+  }
+
+  void WorkerPool::workerLoop(std::size_t queue) {
+    for (;;) {
+      Task task;
+
+      if (findTask(queue, task)) {
+        runTask(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wakeup.wait(lock, [this]() { return m_stop || m_available > 0; });
+
+      if (m_stop) {
+        return;
+      }
+    }
+  }
+
+}
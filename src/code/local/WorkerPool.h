@@ -0,0 +1,92 @@
+/*
+ * Krokodile
+ * Copyright (C) 2018 Hatunruna team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef KKD_WORKER_POOL_H
+#define KKD_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kkd {
+
+  // Fixed set of threads sharing work through per-thread queues. A thread
+  // takes its own tasks first, then steals from the others.
+  class WorkerPool {
+  public:
+    // 0 means one thread per core, the calling thread included
+    explicit WorkerPool(unsigned threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // threads running tasks, the calling thread included
+    std::size_t getThreadCount() const;
+
+    // call func(begin, end) on chunks of [0, count) and wait for the end,
+    // the calling thread takes part in the work
+    template<typename Func>
+    void parallelFor(std::size_t count, std::size_t grain, Func& func) {
+      run(count, grain, [](void *context, std::size_t begin, std::size_t end) {
+        (*static_cast<Func*>(context))(begin, end);
+      }, &func);
+    }
+
+  private:
+    using Invoke = void (*)(void *context, std::size_t begin, std::size_t end);
+
+    struct Task {
+      Invoke invoke;
+      void *context;
+      std::size_t begin;
+      std::size_t end;
+    };
+
+    struct Queue {
+      std::mutex mutex;
+      std::vector<Task> tasks;
+      std::size_t head = 0; // stolen tasks are taken from the head
+    };
+
+    void run(std::size_t count, std::size_t grain, Invoke invoke, void *context);
+
+    bool popTask(std::size_t queue, Task& task);
+    bool stealTask(std::size_t thief, Task& task);
+    bool findTask(std::size_t queue, Task& task);
+    void runTask(const Task& task);
+    void workerLoop(std::size_t queue);
+
+  private:
+    std::vector<std::unique_ptr<Queue>> m_queues; // the first one belongs to the calling thread
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_done;
+    std::atomic<std::size_t> m_available; // queued tasks
+    std::atomic<std::size_t> m_pending; // tasks not finished
+    bool m_stop;
+  };
+
+}
+
+#endif // KKD_WORKER_POOL_H
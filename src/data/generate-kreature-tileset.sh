@@ -5,3 +5,6 @@ montage -geometry +0+0 -background none raw/*Body.png krokodile/kreature_body.pn
 montage -geometry +0+0 -background none raw/*PosteriorLeg.png krokodile/kreature_postleg.png
 montage -geometry +0+0 -background none raw/*AnteriorLeg.png krokodile/kreature_anteleg.png
 montage -geometry +0+0 -background none raw/*Tail.png krokodile/kreature_tail.png
+
+# these strips and the HUD icons are packed in a single atlas at build time,
+# see krokodile-atlas